@@ -39,6 +39,18 @@
 // Some C library header
 #include <cmath>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// POSIX headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 // Reads until a "token" of the same typename T is read is meat
@@ -374,7 +386,7 @@ void debugout(const std::array<T, TSize> &v)
 
         std::cout << *last;
     }
-    std::cout << "}" << std::endl;
+    std::cout << "}\n";
 }
 
 
@@ -473,28 +485,524 @@ reverse(T n)
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Prime check
+// Zero-copy Input Reader
+//
+// The whole input is mapped (or read in large blocks if it cannot be mapped,
+// like a pipe) and lines/tokens are handed out as spans pointing into it.
+//
+//   InputReader reader(argv[1]);
+//   for(auto &&line: reader.lines())
+//       for(auto &&token: tokens(line, " ,|"))
+//           std::copy(token.begin(), token.end(), out);
+///////////////////////////////////////////////////////////////////////////////
+struct Span {
+    const char *first = nullptr;
+    const char *last = nullptr;
+
+    Span() {}
+    Span(const char *first, const char *last) : first(first), last(last) {}
+
+    const char *begin() const { return first; }
+    const char *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    char operator [](size_t i) const { return first[i]; }
+    std::string str() const { return std::string(first, last); }
+};
 
-// Check up to the square root
-template<typename T>
-auto
-is_prime(const T &n)
+
+// Set of separators for the tokens
+struct Separators {
+    bool table[256] = {};
+    int single = -1;  // only one separator: searched for with memchr
+
+    Separators(const char *seps) {
+        auto n = 0;
+        for(; *seps; seps++, n++)
+            table[static_cast<unsigned char>(*seps)] = true;
+        if(n == 1)
+            single = static_cast<unsigned char>(seps[-1]);
+    }
+
+    bool operator ()(char c) const {
+        return table[static_cast<unsigned char>(c)];
+    }
+
+    // First separator in [first, last) or last
+    const char *find(const char *first, const char *last) const {
+        if(single >= 0) {
+            auto p = std::memchr(first, single, last - first);
+            return p ? static_cast<const char *>(p) : last;
+        }
+        while(first != last and not table[static_cast<unsigned char>(*first)])
+            first++;
+        return first;
+    }
+};
+
+
+// Splits a span at the separators, skipping empty tokens (like the stream
+// does with whitespace) unless empties is set (like getline does with lines)
+struct TokenIterator {
+    const char *pos = nullptr;
+    const char *last = nullptr;
+    const Separators *seps = nullptr;
+    bool empties = false;
+    Span token;
+
+    using value_type = Span;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Span *;
+    using reference = const Span &;
+    using iterator_category = std::forward_iterator_tag;
+
+    TokenIterator() {}  // end of any span
+
+    TokenIterator(const Span &span, const Separators &seps, bool empties) :
+        pos(span.first), last(span.last), seps(&seps), empties(empties) {
+        next();
+    }
+
+    void next() {
+        if(not empties)
+            while(pos != last and (*seps)(*pos))
+                pos++;
+
+        if(pos == last) {
+            pos = nullptr;  // equal to the end iterator
+            return;
+        }
+        auto tend = seps->find(pos, last);
+        token = Span(pos, tend);
+        pos = tend + (empties and tend != last);  // skip the separator
+    }
+
+    reference operator *() const { return token; }
+    pointer operator ->() const { return &token; }
+
+    TokenIterator &operator ++() { next(); return *this; }
+
+    TokenIterator operator ++(int) {
+        auto tmp = *this;
+        next();
+        return tmp;
+    }
+
+    bool operator ==(const TokenIterator &other) const {
+        return pos == other.pos;  // past each token: unique
+    }
+    bool operator !=(const TokenIterator &other) const {
+        return not (*this == other);
+    }
+};
+
+
+struct TokenRange {
+    Span span;
+    Separators seps;
+    bool empties;
+
+    TokenRange(const Span &span, const char *seps, bool empties) :
+        span(span), seps(seps), empties(empties) {}
+
+    TokenIterator begin() const { return TokenIterator(span, seps, empties); }
+    TokenIterator end() const { return TokenIterator(); }
+};
+
+
+// The range keeps the separators: iterators must not outlive it
+inline TokenRange
+tokens(const Span &span, const char *seps, bool empties=false)
 {
-    if(n == 2 or n == 3)
-        return true;
+    return TokenRange(span, seps, empties);
+}
+
+
+class InputReader {
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapped = MAP_FAILED;
+    std::vector<char> buffer;  // if it could not be mapped
+
+    static const size_t BLOCKSIZE = 1 << 20;
+
+public:
+    InputReader(const char *path) {
+        auto fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+        if(fd < 0)
+            return;
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped != MAP_FAILED) {
+                madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(mapped);
+                size = st.st_size;
+            }
+        }
+        if(mapped == MAP_FAILED) {
+            for(ssize_t n=1; n > 0; size += n) {
+                buffer.resize(size + BLOCKSIZE);
+                n = read(fd, &buffer[size], BLOCKSIZE);
+                n = std::max<ssize_t>(n, 0);
+            }
+            data = buffer.data();
+        }
+        if(path)
+            close(fd);
+    }
+
+    ~InputReader() {
+        if(mapped != MAP_FAILED)
+            munmap(mapped, size);
+    }
+
+    InputReader(const InputReader &) = delete;
+    InputReader &operator =(const InputReader &) = delete;
+
+    Span all() const { return Span(data, data + size); }
+
+    // Lines without the '\n', empty ones included
+    TokenRange lines() const { return tokens(all(), "\n", true); }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
 
-    if(n < 2 or not (n & 1) or not (n % 3))
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Fixed point with precision decimals, formatted by printf like iostream
+// does for std::fixed (same rounding: exact binary value, ties to even)
+struct Fixed {
+    double value;
+    int precision;
+};
+
+
+inline Fixed
+fixed(double value, int precision)
+{
+    return Fixed{value, precision};
+}
+
+
+inline OutputSink &
+operator <<(OutputSink &sink, const Fixed &f)
+{
+    char buf[352];  // DBL_MAX has 309 integer digits
+    auto n = std::snprintf(buf, sizeof(buf), "%.*f", f.precision, f.value);
+    return sink.write(buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ASCII case kernels: 16 bytes at a time with SSE2 (always there on x86-64)
+// and a scalar tail. Only A-Z/a-z change (as with the "C" locale) and out
+// may be the input itself
+///////////////////////////////////////////////////////////////////////////////
+#ifdef __SSE2__
+// 0xFF for the bytes in [lo, lo + n). No unsigned compare in SSE2: biasing
+// by 128 turns it into a signed one
+inline __m128i
+ascii_range(__m128i v, char lo, char n)
+{
+    auto t = _mm_sub_epi8(v, _mm_set1_epi8(lo + 128));
+    return _mm_cmplt_epi8(t, _mm_set1_epi8(-128 + n));
+}
+#endif
+
+
+inline bool
+ascii_range(char c, char lo, char n)
+{
+    return static_cast<unsigned char>(c - lo) < static_cast<unsigned char>(n);
+}
+
+
+char *
+lowercase(const char *first, const char *last, char *out)
+{
+#ifdef __SSE2__
+    for(; last - first >= 16; first += 16, out += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        auto upper = ascii_range(v, 'A', 26);
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+    }
+#endif
+    for(; first != last; first++)
+        *out++ = ascii_range(*first, 'A', 26) ? (*first | 0x20) : *first;
+    return out;
+}
+
+
+// Letters alternate upper/lower case: parity is the count of letters seen so
+// far (mod 2) and is carried over to the next call for the same line
+char *
+rollercase(const char *first, const char *last, char *out, unsigned &parity)
+{
+#ifdef __SSE2__
+    auto one = _mm_set1_epi8(1);
+    auto x20 = _mm_set1_epi8(0x20);
+    for(; last - first >= 16; first += 16, out += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        auto lower = _mm_or_si128(v, x20);
+        auto letter = ascii_range(lower, 'a', 26);
+
+        // prefix xor of the letter flags: parity after each byte
+        auto f = _mm_and_si128(letter, one);
+        auto p = _mm_xor_si128(f, _mm_slli_si128(f, 1));
+        p = _mm_xor_si128(p, _mm_slli_si128(p, 2));
+        p = _mm_xor_si128(p, _mm_slli_si128(p, 4));
+        p = _mm_xor_si128(p, _mm_slli_si128(p, 8));
+        auto carry = _mm_set1_epi8(parity);
+        auto before = _mm_xor_si128(_mm_xor_si128(p, f), carry);
+
+        auto up = _mm_and_si128(letter,
+                                _mm_cmpeq_epi8(before, _mm_setzero_si128()));
+        v = _mm_or_si128(v, _mm_and_si128(letter, x20));  // all lower
+        v = _mm_xor_si128(v, _mm_and_si128(up, x20));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+
+        parity ^= __builtin_popcount(_mm_movemask_epi8(letter)) & 1;
+    }
+#endif
+    for(; first != last; first++) {
+        auto c = *first;
+        if(ascii_range(c | 0x20, 'a', 26)) {
+            c = (parity ? c | 0x20 : c & ~0x20);
+            parity ^= 1;
+        }
+        *out++ = c;
+    }
+    return out;
+}
+
+
+// Uppercase the letters with a '1' in the same position of the mask
+char *
+uppercase_masked(const char *first, const char *last, const char *mask,
+                 char *out)
+{
+#ifdef __SSE2__
+    for(; last - first >= 16; first += 16, mask += 16, out += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        auto m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask));
+        auto up = _mm_and_si128(ascii_range(v, 'a', 26),
+                                _mm_cmpeq_epi8(m, _mm_set1_epi8('1')));
+        v = _mm_xor_si128(v, _mm_and_si128(up, _mm_set1_epi8(0x20)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+    }
+#endif
+    for(; first != last; first++, mask++)
+        *out++ = (*mask == '1' and ascii_range(*first, 'a', 26)) ?
+            (*first & ~0x20) : *first;
+    return out;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Constexpr primes: sieve table and deterministic Miller-Rabin (64 bits)
+///////////////////////////////////////////////////////////////////////////////
+constexpr uint64_t
+mulmod(uint64_t a, uint64_t b, uint64_t m)
+{
+    return static_cast<unsigned __int128>(a) * b % m;
+}
+
+
+constexpr uint64_t
+powmod(uint64_t b, uint64_t e, uint64_t m)
+{
+    uint64_t r = 1;
+    for(b %= m; e; e >>= 1, b = mulmod(b, b, m))
+        if(e & 1)
+            r = mulmod(r, b, m);
+    return r;
+}
+
+
+// The first 12 primes as bases are enough for any n < 2^64
+constexpr bool
+miller_rabin(uint64_t n)
+{
+    constexpr uint64_t BASES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    if(n < 2)
         return false;
 
-    T rend = static_cast<T>(std::sqrt(n)) + 1;
-    for(T i=3; i < rend; i += 2)
-        if(not (n % i))
+    for(auto p: BASES)
+        if(n % p == 0)
+            return n == p;
+
+    auto d = n - 1;
+    auto s = 0;
+    for(; not (d & 1); d >>= 1)
+        s++;
+
+    for(auto a: BASES) {
+        auto x = powmod(a, d, n);
+        if(x == 1 or x == n - 1)
+            continue;
+
+        auto r = 1;
+        for(; r < s; r++) {
+            x = mulmod(x, x, n);
+            if(x == n - 1)
+                break;
+        }
+        if(r == s)
             return false;
-
+    }
     return true;
 }
 
 
+// Sieve of Eratosthenes over [0, N) usable in constant expressions
+template <size_t N>
+struct PrimeTable {
+    bool composite[N] = {};
+
+    constexpr PrimeTable() {
+        composite[0] = composite[1] = true;
+        for(size_t i=2; i * i < N; i++)
+            if(not composite[i])
+                for(auto j=i * i; j < N; j += i)
+                    composite[j] = true;
+    }
+
+    constexpr bool operator [](size_t n) const { return not composite[n]; }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Prime check
+
+// O(log n) with Miller-Rabin (see below) instead of checking divisors up to
+// the square root
+template<typename T>
+constexpr auto
+is_prime(const T &n)
+{
+    return n >= 0 and miller_rabin(n);
+}
+
+
 // AKS: (bound to fail beyond 63)
 struct Expand_X_1
 {
@@ -80,7 +80,7 @@ struct istream_iterator_until {
 template<typename T>
 void debugout(const T &t)
 {
-    std::cout << t << std::endl;
+    std::cout << t << '\n';
 }
 
 template<typename T>
@@ -94,7 +94,7 @@ void debugout(const std::vector<T> &v)
 
         std::cout << *last;
     }
-    std::cout << "}" << std::endl;
+    std::cout << "}\n";
 }
 
 template<typename T, typename... Args>
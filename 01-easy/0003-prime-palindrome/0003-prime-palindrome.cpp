@@ -19,28 +19,70 @@
 #include <iostream>
 
 // Headers for the implementation
-#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
 
-template<typename T>
-auto
-is_prime(const T &n)
+#include <unistd.h>
+
+
+constexpr uint64_t
+mulmod(uint64_t a, uint64_t b, uint64_t m)
+{
+    return static_cast<unsigned __int128>(a) * b % m;
+}
+
+
+constexpr uint64_t
+powmod(uint64_t b, uint64_t e, uint64_t m)
 {
-    if(n == 2 or n == 3)
-        return true;
+    uint64_t r = 1;
+    for(b %= m; e; e >>= 1, b = mulmod(b, b, m))
+        if(e & 1)
+            r = mulmod(r, b, m);
+    return r;
+}
+
 
-    if(n < 2 or not (n & 1) or not (n % 3))
+// The first 12 primes as bases are enough for any n < 2^64
+constexpr bool
+miller_rabin(uint64_t n)
+{
+    constexpr uint64_t BASES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    if(n < 2)
         return false;
 
-    T rend = static_cast<T>(std::sqrt(n)) + 1;
-    for(T i=3; i < rend; i += 2)
-        if(not (n % i))
-            return false;
+    for(auto p: BASES)
+        if(n % p == 0)
+            return n == p;
+
+    auto d = n - 1;
+    auto s = 0;
+    for(; not (d & 1); d >>= 1)
+        s++;
+
+    for(auto a: BASES) {
+        auto x = powmod(a, d, n);
+        if(x == 1 or x == n - 1)
+            continue;
 
+        auto r = 1;
+        for(; r < s; r++) {
+            x = mulmod(x, x, n);
+            if(x == n - 1)
+                break;
+        }
+        if(r == s)
+            return false;
+    }
     return true;
 }
 
+
 template <typename T>
-auto
+constexpr auto
 is_palindrome(T n)
 {
     T forward = n, backwards = 0;
@@ -52,17 +94,116 @@ is_palindrome(T n)
 }
 
 
+// Largest palindromic prime below the given number (fixed: compile time)
+constexpr int
+prime_palindrome(int below)
+{
+    auto p = below;
+    while(--p > 2)
+        if(is_palindrome(p) and miller_rabin(p))
+            break;
+    return p;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
-
-    int p = 1000;
-    while(--p > 2) {
-        if(is_palindrome(p) and is_prime(p))
-            break;
-    }
-    std::cout << p << std::endl;
+    constexpr auto p = prime_palindrome(1000);
+    sink << p << '\n';
     return 0;
 }
@@ -15,39 +15,150 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <cstring>
 #include <iostream>
+#include <iterator>
+#include <string>
+#include <type_traits>
 
-#include <cmath>
+#include <cstddef>
+
+#include <unistd.h>
+
+
+// Sieve of Eratosthenes over [0, N) usable in constant expressions
+template <size_t N>
+struct PrimeTable {
+    bool composite[N] = {};
+
+    constexpr PrimeTable() {
+        composite[0] = composite[1] = true;
+        for(size_t i=2; i * i < N; i++)
+            if(not composite[i])
+                for(auto j=i * i; j < N; j += i)
+                    composite[j] = true;
+    }
+
+    constexpr bool operator [](size_t n) const { return not composite[n]; }
+};
+
+// The 1000th prime is 7919
+constexpr auto PRIMES = PrimeTable<7920>();
+
+
+// Sum of the first count primes (fixed: compile time)
+constexpr int
+sum_of_primes(int count)
+{
+    auto s = 0;
+    for(auto n=2; count; n++)
+        if(PRIMES[n]) {
+            s += n;
+            count--;
+        }
+    return s;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Main
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
 ///////////////////////////////////////////////////////////////////////////////
-bool
-p_check(const int n)
-{
-    const int rbegin = 3;
-    auto rend = static_cast<int>(std::sqrt(n)) + 1;
-    for(auto i=rbegin; i < rend; i++)
-        if( !(n % i))
-            return false;
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
 
-    return true;
-}
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
 
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
 
-int
-main(int argc, char *argv[]) {
-    int n = 5; // skip 2 and 3
-    int s = 5; // 2 + 3
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
 
-    for(int i=2; i < 1000; n += 2) {
-        if(p_check(n)) {
-            s += n;
-            i++;
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
         }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
     }
-    std::cout << s << std::endl;
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Main
+///////////////////////////////////////////////////////////////////////////////
+int
+main(int argc, char *argv[]) {
+    constexpr auto s = sum_of_primes(1000);
+    sink << s << '\n';
 
     return 0;
 }
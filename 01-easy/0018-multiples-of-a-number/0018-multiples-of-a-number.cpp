@@ -16,11 +16,16 @@
 */
 
 // Headers for test case input/output
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <string>
+#include <type_traits>
 
 #include <iterator>
 
+#include <unistd.h>
+
 ///////////////////////////////////////////////////////////////////////////////
 // Stream Imbuer for Parsing
 // http://stackoverflow.com/questions/1894886/parsing-a-comma-delimited-stdstring
@@ -41,6 +46,128 @@ struct SeparatorReader: std::ctype<char>
     }
 };
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
@@ -48,7 +175,7 @@ int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader(",\n")));
-    auto out = std::ostream_iterator<int>(std::cout, "\n");
+    auto out = SinkIterator<int>(sink, "\n");
 
     int k, n, x;
     while(stream >> k >> n) {
@@ -24,92 +24,361 @@
 #include <iterator>
 
 #include <cctype>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-template <typename T>
-struct istream_iterator_until {
-    std::istream_iterator<T> iter;
-    std::istream_iterator<T> last;
-    T until;
-    bool at_end;
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
-    using value_type = T;
+// Set to 1 to transform the lines with the SIMD case kernels instead of
+// char by char with tolower
+#define SIMD 1
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ASCII case kernels: 16 bytes at a time with SSE2 (always there on x86-64)
+// and a scalar tail. Only A-Z/a-z change (as with the "C" locale) and out
+// may be the input itself
+///////////////////////////////////////////////////////////////////////////////
+#ifdef __SSE2__
+// 0xFF for the bytes in [lo, lo + n). No unsigned compare in SSE2: biasing
+// by 128 turns it into a signed one
+inline __m128i
+ascii_range(__m128i v, char lo, char n)
+{
+    auto t = _mm_sub_epi8(v, _mm_set1_epi8(lo + 128));
+    return _mm_cmplt_epi8(t, _mm_set1_epi8(-128 + n));
+}
+#endif
+
+
+inline bool
+ascii_range(char c, char lo, char n)
+{
+    return static_cast<unsigned char>(c - lo) < static_cast<unsigned char>(n);
+}
+
+
+char *
+lowercase(const char *first, const char *last, char *out)
+{
+#ifdef __SSE2__
+    for(; last - first >= 16; first += 16, out += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        auto upper = ascii_range(v, 'A', 26);
+        v = _mm_or_si128(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+    }
+#endif
+    for(; first != last; first++)
+        *out++ = ascii_range(*first, 'A', 26) ? (*first | 0x20) : *first;
+    return out;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Zero-copy Input Reader
+//
+// The whole input is mapped (or read in large blocks if it cannot be mapped,
+// like a pipe) and lines/tokens are handed out as spans pointing into it.
+//
+//   InputReader reader(argv[1]);
+//   for(auto &&line: reader.lines())
+//       for(auto &&token: tokens(line, " ,|"))
+//           std::copy(token.begin(), token.end(), out);
+///////////////////////////////////////////////////////////////////////////////
+struct Span {
+    const char *first = nullptr;
+    const char *last = nullptr;
+
+    Span() {}
+    Span(const char *first, const char *last) : first(first), last(last) {}
+
+    const char *begin() const { return first; }
+    const char *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    char operator [](size_t i) const { return first[i]; }
+    std::string str() const { return std::string(first, last); }
+};
+
+
+// Set of separators for the tokens
+struct Separators {
+    bool table[256] = {};
+    int single = -1;  // only one separator: searched for with memchr
+
+    Separators(const char *seps) {
+        auto n = 0;
+        for(; *seps; seps++, n++)
+            table[static_cast<unsigned char>(*seps)] = true;
+        if(n == 1)
+            single = static_cast<unsigned char>(seps[-1]);
+    }
+
+    bool operator ()(char c) const {
+        return table[static_cast<unsigned char>(c)];
+    }
+
+    // First separator in [first, last) or last
+    const char *find(const char *first, const char *last) const {
+        if(single >= 0) {
+            auto p = std::memchr(first, single, last - first);
+            return p ? static_cast<const char *>(p) : last;
+        }
+        while(first != last and not table[static_cast<unsigned char>(*first)])
+            first++;
+        return first;
+    }
+};
+
+
+// Splits a span at the separators, skipping empty tokens (like the stream
+// does with whitespace) unless empties is set (like getline does with lines)
+struct TokenIterator {
+    const char *pos = nullptr;
+    const char *last = nullptr;
+    const Separators *seps = nullptr;
+    bool empties = false;
+    Span token;
+
+    using value_type = Span;
     using difference_type = std::ptrdiff_t;
-    using pointer = T *;
-    using reference = T &;
-    using iterator_category = std::output_iterator_tag;
+    using pointer = const Span *;
+    using reference = const Span &;
+    using iterator_category = std::forward_iterator_tag;
 
-    istream_iterator_until() : at_end(true) {}
+    TokenIterator() {}  // end of any span
 
-    istream_iterator_until(std::istream &is, const T &until) :
-        iter(is), last(), until(until), at_end(not is or *iter == until) {}
+    TokenIterator(const Span &span, const Separators &seps, bool empties) :
+        pos(span.first), last(span.last), seps(&seps), empties(empties) {
+        next();
+    }
 
-    T operator *() const { return *iter; }
+    void next() {
+        if(not empties)
+            while(pos != last and (*seps)(*pos))
+                pos++;
 
-    istream_iterator_until& operator ++() {
-        ++iter;
-        at_end = iter == last or *iter == until;
-        return *this;
+        if(pos == last) {
+            pos = nullptr;  // equal to the end iterator
+            return;
+        }
+        auto tend = seps->find(pos, last);
+        token = Span(pos, tend);
+        pos = tend + (empties and tend != last);  // skip the separator
     }
 
-    istream_iterator_until operator ++(int) {
-        istream_iterator_until tmp = *this;
-        ++(*this);
+    reference operator *() const { return token; }
+    pointer operator ->() const { return &token; }
+
+    TokenIterator &operator ++() { next(); return *this; }
+
+    TokenIterator operator ++(int) {
+        auto tmp = *this;
+        next();
         return tmp;
     }
 
-    bool operator !=(const istream_iterator_until &other) const {
+    bool operator ==(const TokenIterator &other) const {
+        return pos == other.pos;  // past each token: unique
+    }
+    bool operator !=(const TokenIterator &other) const {
         return not (*this == other);
     }
+};
+
+
+struct TokenRange {
+    Span span;
+    Separators seps;
+    bool empties;
+
+    TokenRange(const Span &span, const char *seps, bool empties) :
+        span(span), seps(seps), empties(empties) {}
+
+    TokenIterator begin() const { return TokenIterator(span, seps, empties); }
+    TokenIterator end() const { return TokenIterator(); }
+};
+
+
+// The range keeps the separators: iterators must not outlive it
+inline TokenRange
+tokens(const Span &span, const char *seps, bool empties=false)
+{
+    return TokenRange(span, seps, empties);
+}
 
-    bool operator ==(const istream_iterator_until &other) const {
-        if(at_end)
-            return other.at_end;
 
-        if(other.at_end)
-            return false;
+class InputReader {
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapped = MAP_FAILED;
+    std::vector<char> buffer;  // if it could not be mapped
 
-        return iter == other.iter;
+    static const size_t BLOCKSIZE = 1 << 20;
+
+public:
+    InputReader(const char *path) {
+        auto fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+        if(fd < 0)
+            return;
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped != MAP_FAILED) {
+                madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(mapped);
+                size = st.st_size;
+            }
+        }
+        if(mapped == MAP_FAILED) {
+            for(ssize_t n=1; n > 0; size += n) {
+                buffer.resize(size + BLOCKSIZE);
+                n = read(fd, &buffer[size], BLOCKSIZE);
+                n = std::max<ssize_t>(n, 0);
+            }
+            data = buffer.data();
+        }
+        if(path)
+            close(fd);
     }
+
+    ~InputReader() {
+        if(mapped != MAP_FAILED)
+            munmap(mapped, size);
+    }
+
+    InputReader(const InputReader &) = delete;
+    InputReader &operator =(const InputReader &) = delete;
+
+    Span all() const { return Span(data, data + size); }
+
+    // Lines without the '\n', empty ones included
+    TokenRange lines() const { return tokens(all(), "\n", true); }
 };
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Stream Imbuer for Parsing
-// http://stackoverflow.com/questions/1894886/parsing-a-comma-delimited-stdstring
-//    ss.imbue(std::locale(ss.getloc(), new SeparatorReader(" ,|")));
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
 ///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
 
-struct SeparatorReader: std::ctype<char>
-{
-    template<typename T>
-    SeparatorReader(const T &seps): std::ctype<char>(get_table(seps), true) {}
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
 
-    template<typename T>
-    std::ctype_base::mask const *get_table(const T &seps) {
-        auto &&rc = new std::ctype_base::mask[std::ctype<char>::table_size]();
-        for(auto &&sep: seps)
-            rc[static_cast<unsigned char>(sep)] = std::ctype_base::space;
-        return &rc[0];
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
     }
 };
 
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
-    std::ifstream stream(argv[1]);
-    // Nothing is ws ... reading stopped buy _until
-    stream.imbue(std::locale(stream.getloc(), new SeparatorReader("")));
-
-    auto in2 = istream_iterator_until<char>();
-    auto out = std::ostream_iterator<char>(std::cout);
+    InputReader reader(argv[1]);
 
-    while(stream) {
-        auto in1 = istream_iterator_until<char>(stream, '\n');
-        std::transform(in1, in2, out, [] (char c) { return tolower(c); });
-        std::cout << std::endl;
+    std::string out;  // reused: only grows for longer lines
+    for(auto &&line: reader.lines()) {
+        out.resize(line.size() + 1);
+        auto first = &out[0];
+#if SIMD
+        auto oend = lowercase(line.begin(), line.end(), first);
+#else
+        auto oend = std::transform(line.begin(), line.end(), first,
+                                   [] (char c) { return std::tolower(c); });
+#endif
+        *oend = '\n';
+        sink.write(first, out.size());
     }
     return 0;
 }
@@ -21,7 +21,87 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <string>
+#include <type_traits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <unistd.h>
+
+// Set to 1 to transform whole lines with the SIMD case kernels instead of
+// char by char through the stream
+#define SIMD 1
+
+///////////////////////////////////////////////////////////////////////////////
+// ASCII case kernels: 16 bytes at a time with SSE2 (always there on x86-64)
+// and a scalar tail. Only A-Z/a-z change (as with the "C" locale) and out
+// may be the input itself
+///////////////////////////////////////////////////////////////////////////////
+#ifdef __SSE2__
+// 0xFF for the bytes in [lo, lo + n). No unsigned compare in SSE2: biasing
+// by 128 turns it into a signed one
+inline __m128i
+ascii_range(__m128i v, char lo, char n)
+{
+    auto t = _mm_sub_epi8(v, _mm_set1_epi8(lo + 128));
+    return _mm_cmplt_epi8(t, _mm_set1_epi8(-128 + n));
+}
+#endif
+
+
+inline bool
+ascii_range(char c, char lo, char n)
+{
+    return static_cast<unsigned char>(c - lo) < static_cast<unsigned char>(n);
+}
+
+
+// Letters alternate upper/lower case: parity is the count of letters seen so
+// far (mod 2) and is carried over to the next call for the same line
+char *
+rollercase(const char *first, const char *last, char *out, unsigned &parity)
+{
+#ifdef __SSE2__
+    auto one = _mm_set1_epi8(1);
+    auto x20 = _mm_set1_epi8(0x20);
+    for(; last - first >= 16; first += 16, out += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        auto lower = _mm_or_si128(v, x20);
+        auto letter = ascii_range(lower, 'a', 26);
+
+        // prefix xor of the letter flags: parity after each byte
+        auto f = _mm_and_si128(letter, one);
+        auto p = _mm_xor_si128(f, _mm_slli_si128(f, 1));
+        p = _mm_xor_si128(p, _mm_slli_si128(p, 2));
+        p = _mm_xor_si128(p, _mm_slli_si128(p, 4));
+        p = _mm_xor_si128(p, _mm_slli_si128(p, 8));
+        auto carry = _mm_set1_epi8(parity);
+        auto before = _mm_xor_si128(_mm_xor_si128(p, f), carry);
+
+        auto up = _mm_and_si128(letter,
+                                _mm_cmpeq_epi8(before, _mm_setzero_si128()));
+        v = _mm_or_si128(v, _mm_and_si128(letter, x20));  // all lower
+        v = _mm_xor_si128(v, _mm_and_si128(up, x20));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), v);
+
+        parity ^= __builtin_popcount(_mm_movemask_epi8(letter)) & 1;
+    }
+#endif
+    for(; first != last; first++) {
+        auto c = *first;
+        if(ascii_range(c | 0x20, 'a', 26)) {
+            c = (parity ? c | 0x20 : c & ~0x20);
+            parity ^= 1;
+        }
+        *out++ = c;
+    }
+    return out;
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Stream Imbuer for Parsing
@@ -92,17 +172,151 @@ struct istream_iterator_until {
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
+
+#if SIMD
+    std::string line;  // reused: only grows for longer lines
+    while(std::getline(stream, line)) {
+        auto first = &line[0];
+        auto parity = 0u;
+        rollercase(first, first + line.size(), first, parity);
+        line += '\n';
+        sink.write(line.data(), line.size());
+    }
+    return 0;
+#endif
+
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader("")));
 
     // std::string line;
     auto last = istream_iterator_until<char>();
-    auto out = std::ostream_iterator<char>(std::cout);
+    auto out = SinkIterator<char>(sink);
 
     while(stream) {
         auto first = istream_iterator_until<char>(stream, '\n');
@@ -113,7 +327,7 @@ main(int argc, char *argv[]) {
                                return std::toupper(c);
                            return std::tolower(c);
                        });
-        std::cout << std::endl;
+        sink << '\n';
     }
 
     return 0;
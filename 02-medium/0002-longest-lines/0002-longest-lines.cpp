@@ -21,10 +21,25 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <queue>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Set to 1 to scan a memory mapping of the file keeping only the (length,
+// offset) of the N longest lines in a heap instead of copying and sorting
+// all lines
+#define MMAP 1
+
 struct SeparatorReader: std::ctype<char>
 {
     template<typename T>
@@ -39,11 +54,217 @@ struct SeparatorReader: std::ctype<char>
     }
 };
 
+
+// (length, offset) of a line. Comparing the pairs orders by length and for
+// equal lengths by position, which gives the order of the sorting version:
+// stable ascending sort printed in reverse -> later lines first in a tie
+typedef std::pair<size_t, size_t> LineRef;
+
+
+// Non-empty lines in [first, last) -> the count longest, longest first
+std::vector<LineRef>
+longest_lines(const char *first, const char *last, size_t count)
+{
+    // min-heap: the top is the shortest of the current winners
+    auto heap = std::priority_queue<
+        LineRef, std::vector<LineRef>, std::greater<LineRef>>();
+
+    for(auto lbegin=first; lbegin < last;) {
+        auto lend = static_cast<const char *>(
+            std::memchr(lbegin, '\n', last - lbegin));
+        if(lend == nullptr)
+            lend = last;
+
+        auto line = LineRef(lend - lbegin, lbegin - first);
+        if(line.first) {  // empty lines were skipped by the reader
+            if(heap.size() < count)
+                heap.push(line);
+            else if(count and heap.top() < line) {
+                heap.pop();
+                heap.push(line);
+            }
+        }
+        lbegin = lend + 1;
+    }
+
+    auto lines = std::vector<LineRef>(heap.size());
+    for(auto rit=lines.rbegin(); rit != lines.rend(); rit++) {
+        *rit = heap.top();
+        heap.pop();
+    }
+    return lines;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+int
+mmap_main(const char *path)
+{
+    auto fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return 1;
+
+    struct stat st;
+    if(fstat(fd, &st) < 0 or st.st_size == 0) {
+        close(fd);
+        return 0;
+    }
+
+    size_t size = st.st_size;
+    auto mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED)
+        return 1;
+
+    madvise(mapped, size, MADV_SEQUENTIAL);
+    auto first = static_cast<const char *>(mapped);
+    auto last = first + size;
+
+    // 1st line: how many lines have to be printed
+    size_t count = 0;
+    auto p = first;
+    for(; p != last and *p != '\n'; p++)
+        if(*p >= '0' and *p <= '9')
+            count = 10 * count + (*p - '0');
+
+    for(auto &&line: longest_lines(p, last, count)) {
+        sink.write(p + line.second, line.first);
+        sink << '\n';
+    }
+
+    munmap(mapped, size);
+    return 0;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
+#if MMAP
+    return mmap_main(argv[1]);
+#endif
+
     std::ifstream stream(argv[1]);
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader("\n")));
 
@@ -54,15 +275,16 @@ main(int argc, char *argv[]) {
 
     auto in1 = std::istream_iterator<std::string>(stream);
     auto in2 = std::istream_iterator<std::string>();
-    auto out = std::ostream_iterator<std::string>(std::cout, "\n");
+    auto out = SinkIterator<std::string>(sink, "\n");
 
     std::copy(in1, in2, std::back_inserter(vlines));
-    std::sort(vlines.begin(), vlines.end(),
-              [](const std::string &lhs, const std::string &rhs) -> bool {
-                  return lhs.size() < rhs.size();
-              });
+    std::stable_sort(vlines.begin(), vlines.end(),
+                     [](const std::string &lhs, const std::string &rhs) {
+                         return lhs.size() < rhs.size();
+                     });
 
-    std::copy_n(vlines.rbegin(), longest_lines, out);
+    auto count = std::min(vlines.size(), static_cast<size_t>(longest_lines));
+    std::copy_n(vlines.rbegin(), count, out);
 
     return 0;
 }
@@ -21,10 +21,25 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include <unistd.h>
+
+// Set to 1 to read the input in fixed blocks, split with memchr into tokens
+// of any length, keeping only the last tokens of the line in a ring
+#define STREAMING 1
+
+// Tokens remembered behind the current one. A larger m rescans the line
+const size_t RING = 1024;
+
+// Bytes read at once
+const size_t BLOCKSIZE = 1 << 16;
+
 
 template <typename T, typename T2>
 struct istream_iterator_until {
@@ -86,6 +101,281 @@ struct istream_iterator_until {
 };
 
 
+inline bool
+is_blank(char c)
+{
+    return c == '\t' or c == '\r';
+}
+
+
+// Splits a block of input at '\n' (lines) and ' ' (tokens) with memchr. The
+// handler gets the bytes of the tokens, in pieces if they cross blocks, and
+// is told when a token and when a line end. Tokens made only of '\t'/'\r' are
+// not tokens
+template <typename H>
+void
+split_block(const char *first, const char *last, H &handler)
+{
+    while(first != last) {
+        auto nl = static_cast<const char *>(
+            std::memchr(first, '\n', last - first));
+        auto lend = nl ? nl : last;
+
+        for(auto p=first; p != lend;) {
+            auto sp = static_cast<const char *>(
+                std::memchr(p, ' ', lend - p));
+            auto tend = sp ? sp : lend;
+            if(tend != p)
+                handler.bytes(p, tend);
+            if(not sp)
+                break;
+
+            handler.token_end();
+            p = sp + 1;
+        }
+        if(not nl)
+            break;  // the line goes on in the next block
+
+        handler.token_end();
+        handler.line_end(nl + 1);
+        first = nl + 1;
+    }
+}
+
+
+// Reads the stream block by block from the current position until the
+// handler is done or the stream ends (the end of the last line)
+template <typename H>
+void
+split_stream(std::istream &stream, H &handler)
+{
+    char block[BLOCKSIZE];
+    int64_t offset = stream.tellg();  // tellg fails once the end is hit
+    while(not handler.done()) {
+        stream.read(block, BLOCKSIZE);
+        auto n = stream.gcount();
+        if(n <= 0)
+            break;
+
+        handler.block(block, offset);
+        split_block(block, block + n, handler);
+        offset += n;
+    }
+    handler.token_end();
+    handler.line_end(nullptr);
+}
+
+
+// Token index in the line of an input file found again (m beyond the ring)
+struct NthToken {
+    size_t target;
+    std::string &token;
+    size_t index = 0;
+    bool intoken = false;
+    bool solid = false;  // something else than blanks
+    bool ended = false;
+
+    NthToken(size_t target, std::string &token) :
+        target(target), token(token) { token.clear(); }
+
+    bool done() const { return ended; }
+    void block(const char *, int64_t) {}
+
+    void bytes(const char *first, const char *last) {
+        if(ended)
+            return;  // rest of the block past the line
+
+        intoken = true;
+        solid = solid or std::find_if_not(first, last, is_blank) != last;
+        if(index == target)
+            token.append(first, last);
+    }
+
+    void token_end() {
+        if(ended)
+            return;
+
+        if(intoken and solid)
+            index++;
+        else if(index == target)
+            token.clear();  // blanks only
+        intoken = solid = false;
+    }
+
+    void line_end(const char *) { ended = true; }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+// "a b c d 4" -> "a". m is the last token and only known at the end of the
+// line, so the bytes of the last RING + 1 tokens (m itself) are kept in a
+// ring of reused strings. Memory does not depend on the length of the lines
+struct MthToLast {
+    std::istream &rescan;  // the input again, for m larger than the ring
+    std::vector<std::string> ring;
+    size_t count = 0;  // tokens in the line
+    bool intoken = false;
+    bool solid = false;
+    int64_t offset = 0;  // of the current block in the input
+    const char *base = nullptr;  // of the current block
+    int64_t lineoff = 0;  // of the current line in the input
+    std::string element;
+
+    MthToLast(std::istream &rescan) : rescan(rescan), ring(RING + 1) {}
+
+    bool done() const { return false; }
+
+    void block(const char *first, int64_t boff) {
+        base = first;
+        offset = boff;
+    }
+
+    void bytes(const char *first, const char *last) {
+        auto &token = ring[count % ring.size()];
+        if(not intoken)
+            token.clear();
+        intoken = true;
+        solid = solid or std::find_if_not(first, last, is_blank) != last;
+        token.append(first, last);
+    }
+
+    void token_end() {
+        if(intoken and solid)
+            count++;
+        intoken = solid = false;
+    }
+
+    void line_end(const char *next) {
+        print();
+        count = 0;
+        if(next)
+            lineoff = offset + (next - base);
+    }
+
+    void print() {
+        if(count == 0)
+            return;
+
+        size_t m = 0;
+        for(auto c: ring[(count - 1) % ring.size()])
+            if(c >= '0' and c <= '9')
+                m = 10 * m + (c - '0');
+
+        auto elements = count - 1;
+        if(m == 0 or m > elements)
+            return;
+
+        auto target = elements - m;  // index from the start
+        auto token = &ring[target % ring.size()];
+        if(m > RING) {  // not in the ring
+            rescan.clear();
+            rescan.seekg(lineoff);
+            auto nth = NthToken(target, element);
+            split_stream(rescan, nth);
+            token = &element;
+        }
+
+        auto tbegin = std::find_if_not(token->begin(), token->end(), is_blank);
+        auto tlast = std::find_if_not(token->rbegin(),
+                                      std::string::reverse_iterator(tbegin),
+                                      is_blank).base();
+        sink.write(&*tbegin, tlast - tbegin);
+        sink << '\n';
+    }
+};
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
@@ -93,17 +383,26 @@ int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
 
+#if STREAMING
+    std::ifstream rescan(argv[1]);
+    auto mth = MthToLast(rescan);
+    split_stream(stream, mth);
+    return 0;
+#endif
+
     auto in2 = istream_iterator_until<char, std::string>();
     auto elements = std::vector<char>(100);
     auto ebegin = elements.begin();
     while (stream) {
         auto in1 = istream_iterator_until<char, std::string>(stream, "0123456789");
         auto elast = std::copy(in1, in2, ebegin);
-        int mth; stream >> mth;
+        int mth;
+        if(not (stream >> mth))
+            break;  // mth would be garbage
         if(mth > std::distance(ebegin, elast))
             continue;
 
-        std::cout << *std::prev(elast, mth) << std::endl;
+        sink << *std::prev(elast, mth) << '\n';
     }
     return 0;
 }
@@ -22,12 +22,271 @@
 
 // Extra headers
 #include <algorithm>  // remove_if
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include <unistd.h>
+
+// Set to 1 to filter with a 256-bit membership set (SIMD when available)
+// instead of searching the chars for each byte
+#define BYTESET 1
+
+
+// Set of bytes: a scalar table and the nibble tables for the SIMD kernels.
+// Byte b is in the set when bit (hi & 7) of rows[hi >= 8][lo] is set, with
+// hi/lo the high/low nibbles of b
+struct ByteSet {
+    bool table[256];
+    uint8_t rows[2][16];
+
+    ByteSet() {
+        std::memset(table, 0, sizeof(table));
+        std::memset(rows, 0, sizeof(rows));
+    }
+
+    void add(unsigned char b) {
+        table[b] = true;
+        rows[b >> 7][b & 0x0F] |= 1 << ((b >> 4) & 7);
+    }
+
+    void remove(unsigned char b) {
+        table[b] = false;
+        rows[b >> 7][b & 0x0F] &= ~(1 << ((b >> 4) & 7));
+    }
+};
+
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+// Shuffle masks to left-pack the bytes of an 8 byte group: the bits of the
+// index are the bytes to keep
+struct PackTable {
+    uint64_t masks[256];
+
+    PackTable() {
+        for(auto keep=0; keep < 256; keep++) {
+            uint64_t mask = 0;
+            auto n = 0;
+            for(auto i=0; i < 8; i++)
+                if(keep & (1 << i))
+                    mask |= static_cast<uint64_t>(i) << (8 * n++);
+            masks[keep] = mask;
+        }
+    }
+};
+
+const PackTable PACK;
+
+
+// Copies the group bytes flagged in keep to out. Writes 8 bytes (needs room)
+inline char *
+pack8(const char *group, unsigned keep, char *out)
+{
+    auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(group));
+    auto mask = _mm_loadl_epi64(
+        reinterpret_cast<const __m128i *>(&PACK.masks[keep]));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out),
+                     _mm_shuffle_epi8(bytes, mask));
+    return out + __builtin_popcount(keep);
+}
+#endif
+
+
+// Bytes of [first, last) not in the set to out, which must have room for 8
+// bytes more than the input. Returns the end of the output
+char *
+remove_bytes(const char *first, const char *last, const ByteSet &bset,
+             char *out)
+{
+#ifdef __AVX2__
+    auto nibble = _mm256_set1_epi8(0x0F);
+    auto seven = _mm256_set1_epi8(7);
+    auto bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                 1, 2, 4, 8, 16, 32, 64, -128,
+                                 1, 2, 4, 8, 16, 32, 64, -128,
+                                 1, 2, 4, 8, 16, 32, 64, -128);
+    auto row0 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(bset.rows[0])));
+    auto row1 = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(bset.rows[1])));
+
+    for(; last - first >= 32; first += 32) {
+        auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first));
+        auto lo = _mm256_and_si256(v, nibble);
+        auto hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+
+        auto row = _mm256_blendv_epi8(_mm256_shuffle_epi8(row0, lo),
+                                      _mm256_shuffle_epi8(row1, lo),
+                                      _mm256_cmpgt_epi8(hi, seven));
+        auto bit = _mm256_shuffle_epi8(bits, hi);
+        auto hit = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+
+        auto keep = ~static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+        for(auto g=0; g < 4; g++)
+            out = pack8(first + 8 * g, (keep >> (8 * g)) & 0xFF, out);
+    }
+#elif defined(__SSSE3__)
+    auto nibble = _mm_set1_epi8(0x0F);
+    auto seven = _mm_set1_epi8(7);
+    auto bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                              1, 2, 4, 8, 16, 32, 64, -128);
+    auto row0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bset.rows[0]));
+    auto row1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bset.rows[1]));
+
+    for(; last - first >= 16; first += 16) {
+        auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(first));
+        auto lo = _mm_and_si128(v, nibble);
+        auto hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+
+        auto upper = _mm_cmpgt_epi8(hi, seven);  // no blendv before SSE4.1
+        auto row = _mm_or_si128(
+            _mm_andnot_si128(upper, _mm_shuffle_epi8(row0, lo)),
+            _mm_and_si128(upper, _mm_shuffle_epi8(row1, lo)));
+        auto bit = _mm_shuffle_epi8(bits, hi);
+        auto hit = _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
+
+        auto keep = ~static_cast<uint32_t>(_mm_movemask_epi8(hit));
+        out = pack8(first, keep & 0xFF, out);
+        out = pack8(first + 8, (keep >> 8) & 0xFF, out);
+    }
+#endif
+
+    for(; first != last; first++) {  // scalar fallback and tail
+        *out = *first;
+        out += not bset.table[static_cast<unsigned char>(*first)];
+    }
+    return out;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
 
 
 int main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
     std::string line;
 
+#if BYTESET
+    auto bset = ByteSet();
+    std::string out;  // reused: only grows for longer lines
+
+    while(std::getline(stream, line)) {
+        auto comma = std::min(line.find(','), line.size());
+        auto first = line.data();
+
+        // 2nd string starts after ", " and may be empty
+        auto chars = first + std::min(comma + 2, line.size());
+        auto clast = first + line.size();
+        for(auto c=chars; c != clast; c++)
+            bset.add(*c);
+
+        if(out.size() < comma + 8)
+            out.resize(comma + 8);
+
+        auto oend = remove_bytes(first, first + comma, bset, &out[0]);
+        sink.write(out.data(), oend - out.data());
+        sink << '\n';
+
+        for(auto c=chars; c != clast; c++)  // cheaper than a full reset
+            bset.remove(*c);
+    }
+    return 0;
+#endif
+
     while(std::getline(stream, line)) {
         auto comma = line.find(',');
         auto str = line.substr(0, comma);
@@ -43,7 +302,7 @@ int main(int argc, char *argv[]) {
         };
         // remove_if returns an iterator which stops at the "to erase" chars
         str.erase(std::remove_if(str.begin(), str.end(), l), str.end());
-        std::cout << str << std::endl;
+        sink << str << '\n';
     }
     return 0;
 }
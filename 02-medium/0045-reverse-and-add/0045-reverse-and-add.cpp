@@ -21,31 +21,122 @@
 #include <string>
 
 // Extra headers
-#include <utility>  // pair/make_pair
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
+#include <unistd.h>
 
-std::pair<size_t, size_t>
-reverse_and_add(const size_t &input)
-{
-    // For 100% completeness in any scenario this should be elegantly done with
-    // Binary Coded Decimals (the processing overload would be huge)
-
-    // Declaring forward/backwards with "auto" had side effects, probably
-    // because backwards was being given a smaller bit size than start
-    for(size_t i=0, start=input; ;i++) {
-        size_t forward = start;
-        size_t backwards = 0;
-
-        while(forward) {
-            backwards = 10 * backwards + forward % 10;
-            forward /= 10;
+
+// Iterations after which a number is deemed to be a Lychrel number
+const size_t LYCHREL_CAP = 1000;
+
+struct RevAddResult {
+    size_t iterations;
+    std::string palindrome;  // empty if LYCHREL_CAP was reached
+};
+
+
+// Numbers are arrays of decimal digits (units first) and can grow without
+// limit. Every value seen along the way which fits in 64 bits is cached with
+// its result: any later seed reaching it is solved at once
+struct ReverseAndAdd {
+    static const size_t MAXCACHED = 19;  // digits always fitting in 64 bits
+
+    std::unordered_map<uint64_t, RevAddResult> cache;
+    std::vector<uint8_t> digits;
+    std::vector<uint64_t> path;  // values seen at iterations 0, 1, ...
+
+    // Checks if digits is a palindrome and else adds its reverse in place.
+    // The sums of the opposite digits (symmetric) are stored in both places
+    // in the same pass as the check and the carries propagated later
+    bool step() {
+        auto pal = true;
+        auto n = digits.size();
+        for(size_t i=0, j=n - 1; i < j; i++, j--) {
+            pal &= digits[i] == digits[j];
+            digits[i] = digits[j] = digits[i] + digits[j];
+        }
+
+        if(pal) {  // undo the sums: opposite digits were equal
+            for(size_t i=0, j=n - 1; i < j; i++, j--)
+                digits[i] = digits[j] = digits[i] / 2;
+            return true;
+        }
+
+        if(n % 2)
+            digits[n / 2] *= 2;  // the middle digit is added to itself
+
+        uint8_t carry = 0;
+        for(auto &&d: digits) {
+            d += carry;
+            carry = d >= 10;
+            d -= carry * 10;
         }
-        if(start == backwards)
-            return std::make_pair(i, backwards);
+        if(carry)
+            digits.push_back(carry);
 
-        start += backwards;
+        return false;
     }
-}
+
+    RevAddResult operator ()(uint64_t seed) {
+        digits.clear();
+        do {
+            digits.push_back(seed % 10);
+            seed /= 10;
+        } while(seed);
+
+        path.clear();
+        auto result = RevAddResult{LYCHREL_CAP, ""};
+        auto capped = true;
+        for(size_t i=0; i < LYCHREL_CAP; i++) {
+            if(digits.size() <= MAXCACHED) {
+                uint64_t value = 0;
+                for(auto d=digits.rbegin(); d != digits.rend(); d++)
+                    value = 10 * value + *d;
+
+                auto hit = cache.find(value);
+                if(hit != cache.end()) {
+                    result = hit->second;
+                    if(not result.palindrome.empty())
+                        result.iterations += i;
+                    capped = false;
+                    break;
+                }
+                path.push_back(value);
+            }
+
+            if(step()) {
+                result.iterations = i;
+                result.palindrome.assign(digits.rbegin(), digits.rend());
+                for(auto &&c: result.palindrome)
+                    c += '0';
+                capped = false;
+                break;
+            }
+        }
+
+        // Reaching the cap only says something about the seed, but for later
+        // values nothing is known after LYCHREL_CAP - i iterations
+        auto lychrel = result.palindrome.empty();
+        auto cacheable = capped ? std::min<size_t>(1, path.size()) : path.size();
+        for(size_t i=0; i < cacheable; i++) {
+            auto cached = result;
+            cached.iterations -= lychrel ? 0 : i;
+            cache.emplace(path[i], cached);
+        }
+
+        // A cached result may only be reached after too many iterations
+        if(result.iterations >= LYCHREL_CAP)
+            result = RevAddResult{LYCHREL_CAP, ""};
+
+        return result;
+    }
+};
 
 
 struct SeparatorReader: std::ctype<char>
@@ -62,13 +153,110 @@ struct SeparatorReader: std::ctype<char>
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 int main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader("\n")));
 
-    for(auto i=0; stream >> i;) {
+    auto reverse_and_add = ReverseAndAdd();
+
+    for(uint64_t i=0; stream >> i;) {
         auto result = reverse_and_add(i);
-        std::cout << result.first << " " << result.second << std::endl;
+        if(result.palindrome.empty())
+            sink << result.iterations << " lychrel\n";
+        else
+            sink << result.iterations << " " << result.palindrome << '\n';
     }
     return 0;
 }
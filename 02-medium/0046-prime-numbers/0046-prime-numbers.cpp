@@ -19,66 +19,205 @@
 #include <fstream>
 #include <iostream>
 
+// Headers for the implementation
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
 
-// There is a limit to the tradeoff memoization / time spent calculating the
-// primes. Pre-memoization is the best (it could of course be done off-line
-// given that prime numbers is a recurring problem and the result would be
-// stored in an array for quick lookup access
+#include <unistd.h>
 
-template <typename T>
-auto
-isprime(T number)
+
+// Odd only, bit packed sieve of Eratosthenes: bit i tells if 2 * i + 1 is
+// composite. It is grown on demand in segments which fit in the L1 cache,
+// crossing out with the primes (up to the square root of the segment end)
+// it already holds
+struct PrimeSieve {
+    static const uint64_t SEGBITS = 32768 * 8;
+
+    std::vector<uint64_t> bits;
+
+    uint64_t limit() const {  // all numbers < limit are sieved
+        return bits.size() * 64 * 2;
+    }
+
+    bool composite(uint64_t odd) const {
+        auto i = odd / 2;
+        return bits[i / 64] >> (i % 64) & 1;
+    }
+
+    void grow(uint64_t n) {
+        while(limit() < n)
+            sieve_segment();
+    }
+
+    void sieve_segment() {
+        auto lo = bits.size() * 64;  // bit indices of the segment
+        auto hi = lo + SEGBITS;
+        bits.resize(hi / 64, 0);
+        if(not lo)
+            bits[0] |= 1;  // 1 is not a prime
+
+        auto first = 2 * lo + 1;
+        auto last = 2 * hi + 1;  // numbers in [first, last)
+        for(uint64_t p=3; p * p < last; p += 2) {
+            if(composite(p))
+                continue;
+
+            // 1st odd multiple in the segment, but not below p^2
+            auto m = std::max(p * p, (first + p - 1) / p * p);
+            if(not (m & 1))
+                m += p;
+
+            for(auto i=m / 2; i < hi; i += p)
+                bits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+    }
+};
+
+
+// Appends the decimal digits of n
+inline void
+append_uint(std::string &buf, uint64_t n)
 {
-    if((not (number & 1)) and number != 2)
-        return false;
-    if(number % 3 == 0 and number != 3)
-        return false;
-    if(number < 2)
-        return false;
-
-    // if(number < 1373653) {
-    for(T k=1; 36 * k * k - 12 * k < number; ++k)
-        if((number % (6 * k + 1) == 0) or (number % (6 * k - 1) == 0))
-            return false;
-
-    return true;
-    // }
+    char digits[20];
+    auto d = std::end(digits);
+    do {
+        *--d = '0' + n % 10;
+        n /= 10;
+    } while(n);
+    buf.append(d, std::end(digits));
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[])
 {
-    // memoize
-    unsigned short memo[1229];
-    memo[0] = 2;
-    for(unsigned short i=3, count=1; i < 10000; i += 2)
-        if(isprime(i))
-            memo[count++] = i;
-
     std::ifstream stream(argv[1]);
 
-    auto mbegin = std::begin(memo);
-    auto mend = std::end(memo);
-    auto m2nd = std::next(mbegin);
+    auto sieve = PrimeSieve();
+    auto buf = std::string();  // each line is formatted and written at once
 
-    unsigned int input;
+    uint64_t input;
     while(stream >> input) {
-        auto lb = std::lower_bound(mbegin, mend, input);
-        // 0 index (2) is always there
-        if(lb == mend) {
-            std::cout << std::endl;
-            continue;
-        }
+        sieve.grow(input);
+        buf.clear();
+
+        if(input > 2)
+            buf += '2';
 
-        std::cout << *mbegin;
-        for(auto i=m2nd; i < lb; i++)
-            std::cout << ',' << *i;
-        std::cout << std::endl;
+        // primes: zero bits. Odd numbers up to input - 1 (bit (input - 2) / 2)
+        auto nbits = input > 1 ? input / 2 : 0;
+        for(uint64_t w=0; w * 64 < nbits; w++) {
+            auto word = ~sieve.bits[w];
+            if(nbits - w * 64 < 64)
+                word &= (uint64_t(1) << (nbits - w * 64)) - 1;
+
+            for(; word; word &= word - 1) {
+                buf += ',';
+                append_uint(buf, 2 * (w * 64 + __builtin_ctzll(word)) + 1);
+            }
+        }
+        buf += '\n';
+        sink.write(buf.data(), buf.size());
     }
     return 0;
 }
@@ -22,8 +22,81 @@
 #include <iostream>
 
 // Headers for the implementation
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
 #include <iterator>
+#include <ostream>
+#include <sstream>
 #include <string>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+
+// Little endian limbs in base 10^9 to make printing trivial. Only what the
+// counting needs: addition and output
+//
+// The limbs are 64 bits and carries are only propagated (normalize) when a
+// limb could go over MAXBOUND. Additions are then independent per limb (no
+// carry chain)
+struct BigUInt {
+    static const uint64_t BASE = 1000000000;
+    static const uint64_t MAXBOUND = uint64_t(1) << 62;
+
+    std::vector<uint64_t> limbs;
+    uint64_t bound;  // no limb is larger than this
+
+    BigUInt(uint64_t v=0) : limbs(1, v), bound(v) {
+        normalize();
+    }
+
+    void normalize() {
+        uint64_t carry = 0;
+        for(auto &&limb: limbs) {
+            limb += carry;
+            carry = limb / BASE;
+            limb %= BASE;
+        }
+        for(; carry; carry /= BASE)
+            limbs.push_back(carry % BASE);
+
+        bound = BASE - 1;
+    }
+
+    BigUInt &operator +=(const BigUInt &other) {
+        auto osize = other.limbs.size();
+        if(limbs.size() < osize)
+            limbs.resize(osize, 0);
+
+        auto *__restrict__ l = limbs.data();
+        const auto *__restrict__ o = other.limbs.data();
+        for(size_t i=0; i < osize; i++)
+            l[i] += o[i];
+
+        bound += other.bound;  // callers normalize past MAXBOUND: no overflow
+        return *this;
+    }
+};
+
+std::ostream &
+operator <<(std::ostream &os, BigUInt n)
+{
+    n.normalize();
+    auto l = n.limbs.rbegin();
+    while(not *l and std::next(l) != n.limbs.rend())
+        ++l;  // skip leading zero limbs
+
+    os << *l;
+    auto fill = os.fill('0');
+    for(++l; l != n.limbs.rend(); ++l)
+        os << std::setw(9) << *l;
+
+    os.fill(fill);
+    return os;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -31,23 +104,170 @@
 ///////////////////////////////////////////////////////////////////////////////
 const auto ALPHABET = 26;
 
+// The codings up to digit i extend those up to i - 1 if digit i is a letter on
+// its own (not '0') and those up to i - 2 if digits i - 1, i are a letter
+// (10 .. 26). Only the last 2 counts are needed: O(n)
+
+// Each step is one of these updates of (prev, cur) -> (cur, next)
+enum Step { NONE, SINGLE, PAIR, BOTH };
+
+template <typename InT>
+Step
+coding_step(InT cur)
+{
+    auto single = *cur != '0';
+    auto pval = (*std::prev(cur) - '0') * 10 + (*cur - '0');
+    auto pair = *std::prev(cur) != '0' and pval <= ALPHABET;
+    return static_cast<Step>(single + 2 * pair);
+}
+
+// Counting with big numbers, starting at any position with given counts
 template <typename InT>
-auto
+BigUInt
+count_codings_big(InT first, InT last, BigUInt prev, BigUInt cur)
+{
+    for(; first != last; first++) {
+        switch(coding_step(first)) {
+        case NONE:
+            prev = std::move(cur);
+            cur = BigUInt(0);
+            break;
+        case SINGLE:
+            prev = cur;
+            break;
+        case PAIR:
+            std::swap(prev, cur);
+            break;
+        case BOTH:
+            prev += cur;
+            std::swap(prev, cur);
+            break;
+        }
+        if(cur.bound > BigUInt::MAXBOUND) {  // every ~40 steps at most
+            prev.normalize();
+            cur.normalize();
+        }
+    }
+    return cur;
+}
+
+// 64 bits are used until the counts overflow: the big number version then
+// takes over from the overflowing digit on
+template <typename InT>
+std::string
 count_codings(InT first, InT last)
 {
-    if(std::distance(first, last) < 2)
-        return 1;
+    if(first == last)
+        return "1";
 
-    auto second = std::next(first);
+    uint64_t prev = 1;  // empty prefix
+    uint64_t cur = *first != '0';
+    for(auto p=std::next(first); p != last; p++) {
+        auto step = coding_step(p);
+        uint64_t next = 0;
+        if(__builtin_add_overflow((step & SINGLE) ? cur : 0,
+                                  (step & PAIR) ? prev : 0, &next)) {
+            std::ostringstream ss;
+            ss << count_codings_big(p, last, prev, cur);
+            return ss.str();
+        }
+        prev = cur;
+        cur = next;
+    }
+    return std::to_string(cur);
+}
 
-    auto codings = count_codings(second, last);
-    auto cval = static_cast<int>(*first - '0') * 10 + static_cast<int>(*second - '0');
 
-    if(cval <= ALPHABET)
-        codings += count_codings(std::next(second), last);
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
 
-    return codings;
-}
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
 
 
 int
@@ -56,7 +276,7 @@ main(int argc, char *argv[]) {
 
     std::string input;
     while(stream >> input)
-        std::cout << count_codings(input.begin(), input.end()) << std::endl;
+        sink << count_codings(input.begin(), input.end()) << '\n';
 
     return 0;
 }
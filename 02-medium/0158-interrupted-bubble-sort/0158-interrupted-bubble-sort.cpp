@@ -1,4 +1,4 @@
-h/*
+/*
   Copyright (C) 2015 Daniel Rodriguez
 
   This program is free software: you can redistribute it and/or modify
@@ -22,28 +22,43 @@ h/*
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstring>
+#include <functional>
 #include <iterator>
+#include <limits>
+#include <queue>
 #include <type_traits>
 #include <vector>
 
+#include <unistd.h>
+
+// k passes never move a value more than k positions to the left and leave
+// the k largest values sorted at the end. The value which settles in position
+// i is therefore the smallest one not yet placed amongst the first i + k + 1.
+// A min-heap carrying those k + 1 candidates gives the result in a single scan
+// in O(n log k) instead of the O(n k) of actually doing the passes
 template <typename iter, typename iterout>
 auto
 bubblesort_interruptus(iter a1, iter a2, iterout out, size_t iterations)
 {
     using itertype = typename std::decay<decltype(*a1)>::type;
 
-    for(auto i=0; i < iterations; i++) {
-        bool ops = false;
-        for(auto a=a1, b=std::next(a1); b != a2; a++, b++) {
-            if(*a > *b) {
-                ops = true;
-                std::iter_swap(a, b);
-            }
-        }
-        if(not ops)
-            break;
+    std::priority_queue<itertype, std::vector<itertype>,
+                        std::greater<itertype>> heap;
+
+    auto a = a1;
+    for(size_t i=0; i < iterations and a != a2; i++)
+        heap.push(*a++);
+
+    for(; a != a2; a++) {
+        heap.push(*a);
+        *out++ = heap.top();
+        heap.pop();
     }
-    std::copy(a1, a2, out);
+
+    // Sorted tail: the largest values already bubbled to the end
+    for(; not heap.empty(); heap.pop())
+        *out++ = heap.top();
 }
 
 
@@ -65,6 +80,128 @@ struct SeparatorReader: std::ctype<char>
     }
 };
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
@@ -73,7 +210,7 @@ main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader(" |")));
 
-    auto &&ostr = std::ostream_iterator<size_t>(std::cout, " ");
+    auto &&ostr = SinkIterator<size_t>(sink, " ");
     auto &&istr2 = std::istream_iterator<size_t>();
 
     auto &&bubbles = std::vector<size_t>{};
@@ -92,7 +229,7 @@ main(int argc, char *argv[]) {
 
             // Execute the interrupted bubblesort
             bubblesort_interruptus(in1, in2, ostr, iterations);
-            std::cout << std::endl;  // separate testcases
+            sink << '\n';  // separate testcases
         }
 
         if(not stream.eof()) {
@@ -22,39 +22,91 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstring>
 #include <iterator>
+#include <string>
+#include <type_traits>
 
+#include <unistd.h>
 
-const size_t COINS[] = {50, 25, 10, 5};
-const auto CEND = std::end(COINS);
 
+// The 1 cent coin is implicit: any remainder can always be changed with it
+constexpr size_t COINS[] = {50, 25, 10, 5};
+constexpr auto NUMCOINS = sizeof(COINS) / sizeof(COINS[0]);
 
-template<typename ntype, typename iter>
-auto
-calc_changes(ntype cents, iter itcoin)
-{
-    if (not cents or itcoin == CEND)
-        return 1;
+// Amounts up to this bound are a lookup in a table built at compile time
+const size_t CHANGES_BOUND = 4096;
 
-    auto coin = *itcoin;
-    auto coincount = cents / coin;
-    auto changes = 0;
-    for (auto i=0; i <= coincount; i++)
-        changes += calc_changes(cents - coin * i, std::next(itcoin));
+// Amounts a row looks back at most: the largest coin
+const size_t WINDOW = COINS[0] + 1;
 
-    return changes;
-}
+
+// changes[a] with the coins seen so far is the changes without the new coin
+// plus those using it at least once: changes[a - coin]. The last WINDOW
+// amounts of each row (1 cent and COINS[0..k]) are kept to go on past the
+// bound, at amount % WINDOW
+struct ChangesTable {
+    size_t changes[CHANGES_BOUND + 1];
+    size_t tails[NUMCOINS][WINDOW];
+
+    constexpr ChangesTable() : changes(), tails() {
+        for(size_t a=0; a <= CHANGES_BOUND; a++)
+            changes[a] = 1;  // only 1 cent coins
+
+        for(size_t k=0; k < NUMCOINS; k++) {
+            for(auto a=COINS[k]; a <= CHANGES_BOUND; a++)
+                changes[a] += changes[a - COINS[k]];
+
+            for(auto a=CHANGES_BOUND + 1 - WINDOW; a <= CHANGES_BOUND; a++)
+                tails[k][a % WINDOW] = changes[a];
+        }
+    }
+};
+
+constexpr auto CHANGES_TABLE = ChangesTable();
+
+
+// Amounts past the bound: the same DP walked on from the bound keeping only
+// the last WINDOW amounts of each row, whatever the amount. A larger amount
+// continues the walk, one behind the window restarts it from the bound
+struct ChangesDP {
+    size_t rows[NUMCOINS][WINDOW];
+    size_t next;  // first amount not walked yet
+
+    ChangesDP() { restart(); }
+
+    void restart() {
+        std::memcpy(rows, CHANGES_TABLE.tails, sizeof(rows));
+        next = CHANGES_BOUND + 1;
+    }
+
+    size_t operator ()(size_t cents) {
+        if(cents + WINDOW < next)
+            restart();
+
+        for(; next <= cents; next++) {
+            size_t changes = 1;  // only 1 cent coins
+            for(size_t k=0; k < NUMCOINS; k++) {
+                changes += rows[k][(next - COINS[k]) % WINDOW];
+                rows[k][next % WINDOW] = changes;
+            }
+        }
+        return rows[NUMCOINS - 1][cents % WINDOW];
+    }
+};
 
 
 template<typename iter, typename iterout>
 auto
 alternative_reality(iter in, iterout out)
 {
-    auto itcoin = std::find_if(
-        std::begin(COINS), CEND,
-        [&in] (size_t coin) { return coin <= *in;});
+    static auto changes_dp = ChangesDP();
 
-    *out++ = calc_changes(*in, itcoin);
+    auto cents = *in;
+    if(cents <= CHANGES_BOUND)
+        *out++ = CHANGES_TABLE.changes[cents];
+    else
+        *out++ = changes_dp(cents);
 }
 
 
@@ -73,12 +125,133 @@ struct SeparatorReader: std::ctype<char>
 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader("\n")));
 
-    auto out = std::ostream_iterator<size_t>(std::cout, "\n");
+    auto out = SinkIterator<size_t>(sink, "\n");
     auto in1 = std::istream_iterator<size_t>(stream);
     auto in2 = std::istream_iterator<size_t>();
 
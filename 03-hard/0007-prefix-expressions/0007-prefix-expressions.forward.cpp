@@ -20,17 +20,21 @@
 #include <iostream>
 
 // Headers for the implementation
-#include <functional>
+#include <cstring>
+#include <deque>
 #include <iterator>
-#include <map>
 #include <string>
+#include <type_traits>
 
 #include <cmath>
 
+#include <unistd.h>
+
 //
 // Solution compiles fine and solves the challenge but the usage of map
-// function and iterators seems to be to much for the compilation with g++
-// 4.8.1 under codeeval which always aborts compilation after 10 seconds
+// function and iterators seemed to be to much for the compilation with g++
+// 4.8.1 under codeeval which always aborts compilation after 10 seconds. The
+// operations are now a plain enum tag (calls inline) and the map is gone
 
 ///////////////////////////////////////////////////////////////////////////////
 // Stream Imbuer for Parsing
@@ -51,57 +55,240 @@ struct SeparatorReader: std::ctype<char>
 };
 
 
+enum OpTag { OP_ADD, OP_MUL, OP_DIV };
+
+inline OpTag
+optag(char op)
+{
+    return op == '+' ? OP_ADD : op == '*' ? OP_MUL : OP_DIV;
+}
+
+inline double
+operate(OpTag operation, double opa, double opb)
+{
+    switch(operation) {
+        case OP_ADD:
+            return opa + opb;
+        case OP_MUL:
+            return opa * opb;
+        default:
+            return opa / opb;
+    }
+}
+
+
+struct Operat;
+
+// Nodes come from an arena instead of new/delete. Released nodes are chained
+// in a free list (through parent) for reuse and the arena is reset once an
+// expression is complete. Memory is bounded by the deepest expression
+struct OperatPool {
+    std::deque<Operat> nodes;  // addresses are stable when growing
+    size_t used = 0;
+    Operat *freelist = nullptr;
+
+    Operat *make(Operat *parent, OpTag operation);
+
+    void release(Operat *node);
+
+    void reset() {
+        used = 0;
+        freelist = nullptr;
+    }
+};
+
+
 struct Operat {
-    using OperationT = std::function<double(double, double)>;
-    static std::map<char, OperationT> OPERATIONS;
+    static OperatPool pool;
 
     Operat *parent;
-    OperationT *operation;
+    OpTag operation;
 
     double opa;
 
-    Operat(Operat *parent=nullptr, OperationT *operation=nullptr) :
+    Operat(Operat *parent=nullptr, OpTag operation=OP_ADD) :
         parent(parent), operation(operation), opa(NAN) {}
 
     Operat *addtoken(double op, Operat *child) {
-        delete child;
+        pool.release(child);
 
         if(std::isnan(opa)) {  // no operand yet
             opa = op;  // store
             return this;
         }
-        return parent->addtoken((*operation)(opa, op), this);
+        return parent->addtoken(operate(operation, opa, op), this);
     }
 
     Operat *addtoken(const std::string &token) {
         if(not std::isdigit(token[0]))  // operator
-            return new Operat(this, &OPERATIONS[token[0]]);
+            return pool.make(this, optag(token[0]));
 
         if(std::isnan(opa)) {  // no operand yet
             opa = std::stod(token);  // store
             return this;
         }
 
-        return parent->addtoken((*operation)(opa, std::stod(token)), this);
+        return parent->addtoken(operate(operation, opa, std::stod(token)), this);
     }
 
     bool iscomplete() { return parent == nullptr; }
 
-    void reset() { opa = NAN; }
+    void reset() {
+        opa = NAN;
+        pool.reset();  // all nodes of the expression are done
+    }
+};
+
+OperatPool Operat::pool;
+
+
+Operat *
+OperatPool::make(Operat *parent, OpTag operation)
+{
+    Operat *node;
+    if(freelist) {
+        node = freelist;
+        freelist = node->parent;
+    } else {
+        if(used == nodes.size())
+            nodes.emplace_back();
+        node = &nodes[used++];
+    }
+    *node = Operat(parent, operation);
+    return node;
+}
+
+void
+OperatPool::release(Operat *node)
+{
+    if(node) {
+        node->parent = freelist;
+        freelist = node;
+    }
+}
+
 
-    void destroy(Operat *child=nullptr) {
-        delete child;
-        parent == nullptr ? delete this : parent->destroy(this);
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
     }
 };
 
-std::map<char, Operat::OperationT> Operat::OPERATIONS = {
-        {'+', Operat::OperationT(std::plus<double>())},
-        {'*', Operat::OperationT(std::multiplies<double>())},
-        {'/', Operat::OperationT(std::divides<double>())},
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
 };
 
 
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
@@ -113,9 +300,10 @@ main(int argc, char *argv[]) {
 
     auto in1 = std::istream_iterator<std::string>(stream);
     auto in2 = std::istream_iterator<std::string>();
-    auto out = std::ostream_iterator<int>(std::cout, "\n");
+    auto out = SinkIterator<int>(sink, "\n");
 
-    auto curop = new Operat();
+    auto root = Operat();  // holds the result, operators come from the pool
+    auto curop = &root;
     for(auto in=in1; in != in2; in++) {
         curop = curop->addtoken(*in);
         if(curop->iscomplete()) {
@@ -123,7 +311,6 @@ main(int argc, char *argv[]) {
             curop->reset();
         }
     }
-    curop->destroy();
 
     return 0;
 }
@@ -20,66 +20,244 @@
 #include <iostream>
 
 // Headers for the implementation
-#include <algorithm>
-#include <functional>
+#include <cstring>
 #include <iterator>
-#include <map>
-#include <sstream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include <unistd.h>
+
 //
-// Solution compiles fine and solves the challenge but the usage of map
-// function and iterators seems to be to much for the compilation with g++
-// 4.8.1 under codeeval which always aborts compilation after 10 seconds
+// Operators are dispatched through a computed goto table (labels as values,
+// a GNU extension) indexed by the operator char
+
+// Operands on the stack before it has to grow (nested operators)
+const auto MAXSTACK = 1024;
+
+
+inline bool
+is_separator(char c)
+{
+    return c == ' ' or c == '\t' or c == '\r';
+}
+
+
+// Integer or decimal ("12", "0.5") number in [first, last)
+inline double
+parse_number(const char *first, const char *last)
+{
+    double value = 0;
+    for(; first != last and *first != '.'; first++)
+        value = 10 * value + (*first - '0');
+
+    if(first != last) {  // fractional part
+        double fraction = 0;
+        double scale = 1;
+        for(first++; first != last; first++) {
+            fraction = 10 * fraction + (*first - '0');
+            scale *= 10;
+        }
+        value += fraction / scale;
+    }
+    return value;
+}
+
+
+// Operands: a fixed array on the stack, moved to the heap only if it fills up
+struct OpStack {
+    double fixed[MAXSTACK];
+    std::vector<double> grown;
+    double *base = fixed;
+    double *top = fixed;  // 1 past the last operand
+    double *cap = fixed + MAXSTACK;
+
+    OpStack() {}
+    OpStack(const OpStack &) = delete;  // points into itself
+
+    size_t size() const { return top - base; }
+
+    void push(double value) {
+        if(top == cap) {
+            auto n = size();
+            if(grown.empty())
+                grown.assign(base, top);
+            grown.resize(2 * n);
+            base = grown.data();
+            top = base + n;
+            cap = base + grown.size();
+        }
+        *top++ = value;
+    }
+
+    double result() const { return size() ? base[0] : 0; }
+};
+
+
+// Tokens are taken right to left straight from the line: operands are pushed
+// to the stack and operators pop 2 and push the result. Unknown operators
+// and operators without 2 operands are ignored
+double
+prefix_eval(const char *first, const char *last)
+{
+    OpStack stack;
+
+    static void *OPERATIONS[256] = {};
+    if(not OPERATIONS['+']) {
+        for(auto &&operation: OPERATIONS)
+            operation = &&op_unknown;
+        OPERATIONS['+'] = &&op_add;
+        OPERATIONS['*'] = &&op_mul;
+        OPERATIONS['/'] = &&op_div;
+    }
+
+    for(auto tend=last; tend != first;) {
+        if(is_separator(*(tend - 1))) {
+            tend--;
+            continue;
+        }
+
+        auto tbegin = tend;
+        while(tbegin != first and not is_separator(*(tbegin - 1)))
+            tbegin--;
+
+        auto tlast = tend;
+        tend = tbegin;
+
+        auto op = *tbegin;
+        if(op >= '0' and op <= '9') {  // operand
+            stack.push(parse_number(tbegin, tlast));
+            continue;
+        }
+
+        if(stack.size() < 2)
+            continue;
+
+        // operator seen ... show time: a is the top and b goes below
+        auto top = stack.top - 1;
+        goto *OPERATIONS[static_cast<unsigned char>(op)];
+op_add:
+        top[-1] = top[0] + top[-1];
+        stack.top = top;
+        continue;
+op_mul:
+        top[-1] = top[0] * top[-1];
+        stack.top = top;
+        continue;
+op_div:
+        top[-1] = top[0] / top[-1];
+        stack.top = top;
+        continue;
+op_unknown:
+        continue;
+    }
+    return stack.result();
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
-// Main
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
 ///////////////////////////////////////////////////////////////////////////////
-int
-main(int argc, char *argv[]) {
-    std::ifstream stream(argv[1]);
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
 
-    using OperationT = std::function<double(double, double)>;
-    std::map<char, OperationT> OPERATIONS = {
-        {'+', OperationT(std::plus<double>())},
-        {'*', OperationT(std::multiplies<double>())},
-        {'/', OperationT(std::divides<double>())},
-    };
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
 
-    auto in2 = std::istream_iterator<std::string>();
-    auto out = std::ostream_iterator<int>(std::cout, "\n");
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
 
-    std::string line;
-    std::istringstream isstream;
-    while(std::getline(stream, line)) {
-        isstream.str(line);
-        isstream.clear();
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
 
-        auto in1 = std::istream_iterator<std::string>(isstream);
-
-        auto ptokens = std::vector<std::string>();
-        std::copy(in1, in2, std::back_inserter(ptokens));
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
 
-        auto opstack = std::vector<double>();
-        for(auto ptoken=ptokens.crbegin(); ptoken != ptokens.crend(); ptoken++) {
-            auto &&token = *ptoken;
-            if(std::isdigit(token[0])) {  // operand
-                opstack.push_back(std::stod(token));
-                continue;
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
             }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
 
-            // operator seen ... show time
-            auto opa = opstack.back();  // get operand a
-            opstack.pop_back();
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
 
-            auto opb = opstack.back();  // get operand b
-            opstack.pop_back();
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
 
-            // operate and push on to the stack
-            opstack.push_back(OPERATIONS[token[0]](opa, opb));
-        }
-        *out++ = static_cast<int>(opstack.front());
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Main
+///////////////////////////////////////////////////////////////////////////////
+int
+main(int argc, char *argv[]) {
+    std::ifstream stream(argv[1]);
+
+    std::string line;  // reused: only grows for longer lines
+    while(std::getline(stream, line)) {
+        auto result = prefix_eval(line.data(), line.data() + line.size());
+        sink << static_cast<int>(result) << '\n';
     }
 
     return 0;
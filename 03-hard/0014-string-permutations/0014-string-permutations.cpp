@@ -21,8 +21,225 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <condition_variable>
+#include <cstring>
 #include <iterator>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+
+// Permutations of the string are split in tasks by a common (distinct)
+// prefix, long enough to leave at most this number of suffix permutations
+const size_t TASK_PERMUTATIONS = 40320;  // 8!
+
+
+// A task is a permutation whose first plen chars are the prefix and the rest
+// is sorted. Moves to the next distinct prefix, in lexicographic order,
+// returning false after the last one
+bool
+next_task(std::string &task, size_t plen)
+{
+    std::reverse(std::next(task.begin(), plen), task.end());  // last suffix
+    return std::next_permutation(task.begin(), task.end());
+}
+
+
+// All the permutations of a task as "perm," records in buf
+void
+emit_permutations(std::string perm, size_t plen, std::string &buf)
+{
+    auto sfirst = std::next(perm.begin(), plen);
+
+    size_t nperms = 1;  // upper bound (exact without repeated chars)
+    for(size_t i=2; i <= perm.size() - plen; i++)
+        nperms *= i;
+
+    buf.clear();
+    buf.reserve(nperms * (perm.size() + 1));
+    do {
+        buf.append(perm);
+        buf += ',';
+    } while(std::next_permutation(sfirst, perm.end()));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+// A fixed pool of threads takes the tasks as they are generated and the
+// calling thread writes the results in order. Tasks are only taken when their
+// slot in a window of 2 per thread is free: the memory used is bounded by
+// the window, whatever the length of the string
+void
+string_permutations(std::string s, OutputSink &os)
+{
+    std::sort(s.begin(), s.end());
+
+    size_t plen = 0;
+    for(size_t perms=1, i=2; i <= s.size(); i++)
+        if((perms *= i) > TASK_PERMUTATIONS)
+            plen++;
+
+    size_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+    auto window = 2 * nthreads;
+    auto slots = std::vector<std::string>(window);
+    auto ready = std::vector<char>(window);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    auto task = s;  // next task to be taken
+    auto more = true;  // tasks left
+    size_t taken = 0, written = 0;
+
+    auto worker = [&]() {
+        std::string buf;
+        std::unique_lock<std::mutex> lock(mutex);
+        while(true) {
+            cv.wait(lock, [&]() {
+                return not more or taken < written + window;
+            });
+            if(not more)
+                return;
+
+            auto seq = taken++;
+            auto perm = task;
+            more = next_task(task, plen);
+            lock.unlock();
+
+            emit_permutations(perm, plen, buf);
+
+            lock.lock();
+            std::swap(slots[seq % window], buf);
+            ready[seq % window] = true;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(size_t t=0; t < nthreads; t++)
+        threads.emplace_back(worker);
+
+    std::string buf;
+    while(true) {
+        std::unique_lock<std::mutex> lock(mutex);
+        auto slot = written % window;
+        cv.wait(lock, [&]() {
+            return ready[slot] or (not more and written == taken);
+        });
+        if(not ready[slot])
+            break;  // all written
+
+        std::swap(slots[slot], buf);  // the worker gets the old buffer back
+        ready[slot] = false;
+        written++;
+        auto last = not more and written == taken;
+        cv.notify_all();
+        lock.unlock();
+
+        if(last)
+            buf.back() = '\n';  // last permutation: no separator
+
+        os.write(buf.data(), buf.size());
+    }
+
+    for(auto &&thread: threads)
+        thread.join();
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // Main
@@ -34,15 +251,8 @@ main(int argc, char *argv[]) {
     auto in1 = std::istream_iterator<std::string>(stream);
     auto in2 = std::istream_iterator<std::string>();
 
-    for(auto in=in1; in != in2; in++) {
-        auto s = *in;
-        std::sort(s.begin(), s.end());
-        std::cout << s;
-
-        while(std::next_permutation(s.begin(), s.end()))
-            std::cout << ',' << s;
-        std::cout << std::endl;
-    }
+    for(auto in=in1; in != in2; in++)
+        string_permutations(*in, sink);
 
     return 0;
 }
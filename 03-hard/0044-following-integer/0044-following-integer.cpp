@@ -23,89 +23,167 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstring>
 #include <iterator>
-#include <vector>
+#include <string>
+#include <type_traits>
 
+#include <unistd.h>
+
+
+// Digits are chars '0'-'9'. The suffix after the digit which is increased is
+// rebuilt in ascending order from a histogram of its digits: O(d) in total
+// and no allocation as long as the buffers are reused
 template <typename InT, typename OutT>
 auto
 following_integer(InT first, InT last, OutT out)
 {
-    using InType = typename std::iterator_traits<InT>::value_type;
+    size_t counts[10] = {0};
+
+    // from the right: the suffix is non-increasing until a digit is smaller
+    // than the one to its right. Making it larger is the smallest increase
     auto rlast = std::reverse_iterator<InT>(last);
     auto rfirst = std::reverse_iterator<InT>(first);
+    auto target = rlast;
+    for(auto prev='0'; target != rfirst and *target >= prev; prev=*target++)
+        counts[*target - '0']++;
+
+    if(target != rfirst) {
+        // swap in the smallest greater digit from the suffix
+        auto digit = *target - '0';
+        auto greater = digit + 1;
+        while(not counts[greater])
+            greater++;
+
+        counts[greater]--;
+        counts[digit]++;
+        *target = '0' + greater;
+
+        out = std::copy(first, target.base(), out);
+    } else {
+        // no movement of digits can make it larger: lowest ordering with an
+        // extra zero, i.e. the lowest non zero digit first and then all zeros
+        auto nonzero = 1;
+        while(nonzero < 10 and not counts[nonzero])
+            nonzero++;
+
+        if(nonzero < 10) {  // only zeros: nothing larger, they are left as is
+            counts[nonzero]--;
+            counts[0]++;
+            *out++ = '0' + nonzero;
+        }
+    }
 
-    // in the 1st part we try to move one digit forward to make the figure
-    // greater and then sort the lower part to have the mininum possible value
-    for(auto start=rlast, target=std::next(rlast); target != rfirst; start++, target++) {
-        auto mingreat = std::numeric_limits<InType>::max();
-        auto minit = target;
-
-        // find the min greater than target, to do a swap
-        for(auto check=rlast; check != target; check++) {
-            if(*check > *target and *check < mingreat) {
-                minit = check;
-                mingreat = *check;
-            }
+    for(auto d=0; d < 10; d++)  // suffix in ascending order
+        out = std::fill_n(out, counts[d], '0' + d);
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
         }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
 
-        if(minit == target)
-            continue;  // no min greater continue search
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
 
-        std::iter_swap(minit, target);  // found: swap values
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
 
-        // find out how far away from the beginning we stopped
-        auto d = std::distance(target, rfirst);
-        std::sort(std::next(first, d), last);  // sort only the lower part
-        std::copy(first, last, out);  // send to output iterator
-        return;
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
     }
 
-    // no movement of digits is possible to make it larger. Need to get lowest
-    // ordering and insert a 2nd left most zero. The lowest ordering is the one
-    // with a significant digit (non zero) at the left most part
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
 
-    std::sort(first, last);  // lower value
-    // find first nonzero
-    auto nonzero = std::find_if(first, last, [](const InType &a) { return a;});
-    std::iter_swap(first, nonzero);  // swap values
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
 
-    *out++ = *first;  // output now lower
-    *out++ = not bool(*first);  // output the zero, calculate it
-    std::copy(std::next(first), last, out);  // copy the rest out
-}
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
 
-auto
-int_range(int number)
-{
-    // receive an int an return and return a range with the digits
-    const auto MAX_POSITIONS = 6;
-    static std::vector<int> vnumber(MAX_POSITIONS);  // n < 10^6
-    auto vbegin = vnumber.begin();
-
-    auto i = 0;
-    while(number) {
-        vnumber[i++] = number % 10;
-        number /= 10;
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
     }
+};
 
-    auto vend = std::next(vbegin, i);
-    std::reverse(vbegin, vend);
-    return std::make_pair(vbegin, vend);
-}
+
+OutputSink sink;  // flushed at exit
 
 
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
 
-    auto out = std::ostream_iterator<int>(std::cout);
-
-    int number;
+    // Digit strings of any length. Buffers are reused across test cases
+    std::string number;
+    std::string result;
     while(stream >> number) {
-        auto range = int_range(number);
-        following_integer(range.first, range.second, out);
-        std::cout << std::endl;
-
+        result.clear();
+        following_integer(number.begin(), number.end(),
+                          std::back_inserter(result));
+        result += '\n';
+        sink << result;
     }
     return 0;
 }
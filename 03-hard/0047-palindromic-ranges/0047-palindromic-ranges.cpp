@@ -22,52 +22,187 @@
 #include <iostream>
 
 // Headers for the implementation
-#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
-#include <vector>
+#include <string>
+#include <type_traits>
+
+#include <unistd.h>
+
+
+// Produces the palindromes >= from in increasing order by mirroring the first
+// half of the digits, instead of testing each integer in the range
+struct PalindromeGenerator {
+    uint64_t half;  // first (ndigits + 1) / 2 digits of the palindrome
+    uint64_t halfend;  // 10 ^ number of digits in half
+    bool odd;  // odd number of digits: middle digit not repeated
+
+    explicit PalindromeGenerator(uint64_t from) {
+        auto ndigits = 1;
+        for(auto f=from; f >= 10; f /= 10)
+            ndigits++;
+
+        odd = ndigits % 2;
+        auto hdigits = (ndigits + 1) / 2;
+        halfend = 1;
+        for(auto i=0; i < hdigits; i++)
+            halfend *= 10;
+
+        half = from;
+        for(auto i=hdigits; i < ndigits; i++)
+            half /= 10;
+
+        if(**this < from)
+            ++(*this);
+    }
+
+    uint64_t operator *() const {
+        auto p = half;
+        for(auto t = odd ? half / 10 : half; t; t /= 10)
+            p = 10 * p + t % 10;
+        return p;
+    }
+
+    PalindromeGenerator &operator ++() {
+        if(++half == halfend) {  // all palindromes with ndigits seen
+            if(odd)
+                half /= 10;  // next: even digits, same half width
+            else
+                halfend *= 10;  // next: odd digits, one more half digit
+            odd = not odd;
+        }
+        return *this;
+    }
+};
+
+
+// A subrange [i, j] has an even number of palindromes if the palindrome counts
+// of the prefixes ending at i - 1 and j have the same parity. Counting how many
+// prefixes are even/odd gives the number of subranges in O(1) per palindrome
+uint64_t
+palindromic_ranges(uint64_t first, uint64_t last)
+{
+    uint64_t parities[2] = {0, 0};
+    auto parity = 0;
+    auto prev = first - 1;  // prefix before first is the empty one (even)
+
+    for(auto pg=PalindromeGenerator(first); *pg <= last; ++pg) {
+        parities[parity] += *pg - prev;  // prefixes prev .. palindrome - 1
+        parity = not parity;
+        prev = *pg;
+    }
+    parities[parity] += last - prev + 1;  // prefixes from last palindrome on
+
+    return parities[0] * (parities[0] - 1) / 2 +
+        parities[1] * (parities[1] - 1) / 2;
+}
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 
-int
-main(int argc, char *argv[]) {
-    std::ifstream stream(argv[1]);
 
-    int first, last;
-    while(stream >> first and stream >> last) {
-
-        auto palins = std::vector<int>(last - first + 1);
-        std::iota(palins.begin(), palins.end(), first);
-        std::transform(
-            palins.begin(), palins.end(), palins.begin(),
-            [] (int p) -> int {
-                int forward = p;
-                int backwards = 0;
-
-                while(forward) {
-                    backwards = 10 * backwards + forward % 10;
-                    forward /= 10;
-                }
-                return static_cast<int>(p == backwards);
-        });
-
-        auto size = static_cast<ssize_t>(palins.size());
-        auto iranges = 0;
-
-        auto pbegin = palins.begin();
-
-        for(auto rangesize=0; rangesize < size; rangesize++) {
-            for(auto col=0; col < size - rangesize; col++) {
-                auto s = std::accumulate(std::next(pbegin, col),
-                                         std::next(pbegin, col + rangesize + 1),
-                                         0);
-                iranges += not (s % 2);
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
             }
         }
-        std::cout << iranges << std::endl;
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
     }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+int
+main(int argc, char *argv[]) {
+    std::ifstream stream(argv[1]);
+
+    uint64_t first, last;
+    while(stream >> first and stream >> last)
+        sink << palindromic_ranges(first, last) << '\n';
 
     return 0;
 }
@@ -21,134 +21,205 @@
 
 // Headers for the implementation
 #include <algorithm>
-#include <iomanip>
+#include <cstdio>
 #include <iterator>
+#include <limits>
 #include <map>
+#include <numeric>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <cctype>
+#include <cstring>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-// This iterator wrapper is thought for an istream_iterator overload of
-// std::string (and potentially something else) for non-ws is good.
-// If ",;" are the only characters defined as ws and ';' is the terminator but
-// ',' is the token separator) the wrapper will peek the next incoming char when
-// incrementing ++ to see if the upcoming ws is the "terminator" and set itself
-// to "at_end". Else it must be the other ws, which is the token separator and
-// parsing can continue
 
-// During init, the incoming char has to be checked to avoid initialization of
-// "iter" with the stream which will automatically engage into parsing and a
-// token may me unwillfully skipped.
-
-template <typename T>
-struct istream_iterator_until {
-    std::istream *is;
-    bool at_end = false;
+///////////////////////////////////////////////////////////////////////////////
+// Zero-copy Input Reader
+//
+// The whole input is mapped (or read in large blocks if it cannot be mapped,
+// like a pipe) and lines/tokens are handed out as spans pointing into it.
+//
+//   InputReader reader(argv[1]);
+//   for(auto &&line: reader.lines())
+//       for(auto &&token: tokens(line, " ,|"))
+//           std::copy(token.begin(), token.end(), out);
+///////////////////////////////////////////////////////////////////////////////
+struct Span {
+    const char *first = nullptr;
+    const char *last = nullptr;
+
+    Span() {}
+    Span(const char *first, const char *last) : first(first), last(last) {}
+
+    const char *begin() const { return first; }
+    const char *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    char operator [](size_t i) const { return first[i]; }
+    std::string str() const { return std::string(first, last); }
+};
 
-    using TIter = std::istream_iterator<T>;
-    std::istream_iterator<T> iter;
-    std::istream_iterator<T> last;
 
-    typename T::value_type until;
+// Set of separators for the tokens
+struct Separators {
+    bool table[256] = {};
+    int single = -1;  // only one separator: searched for with memchr
 
-    bool pre_end = false;
+    Separators(const char *seps) {
+        auto n = 0;
+        for(; *seps; seps++, n++)
+            table[static_cast<unsigned char>(*seps)] = true;
+        if(n == 1)
+            single = static_cast<unsigned char>(seps[-1]);
+    }
 
-    using value_type = T;
-    using difference_type = std::ptrdiff_t;
-    using pointer = T *;
-    using reference = T &;
-    using iterator_category = std::output_iterator_tag;
+    bool operator ()(char c) const {
+        return table[static_cast<unsigned char>(c)];
+    }
 
-    istream_iterator_until() : at_end(true) {}
+    // First separator in [first, last) or last
+    const char *find(const char *first, const char *last) const {
+        if(single >= 0) {
+            auto p = std::memchr(first, single, last - first);
+            return p ? static_cast<const char *>(p) : last;
+        }
+        while(first != last and not table[static_cast<unsigned char>(*first)])
+            first++;
+        return first;
+    }
+};
 
-    istream_iterator_until(std::istream &is, const typename T::value_type &until) :
-        is(&is), at_end((not is) or is.peek() == until), iter(), last(), until(until) {
 
-        // avoid init with stream if at_end else the next token will be
-        // automaticall consumed (and therfore will be skipped by the logic)
-        if(not at_end)
-            iter = TIter(is);
+// Splits a span at the separators, skipping empty tokens (like the stream
+// does with whitespace) unless empties is set (like getline does with lines)
+struct TokenIterator {
+    const char *pos = nullptr;
+    const char *last = nullptr;
+    const Separators *seps = nullptr;
+    bool empties = false;
+    Span token;
 
-        check_end();
-    }
+    using value_type = Span;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Span *;
+    using reference = const Span &;
+    using iterator_category = std::forward_iterator_tag;
 
-    const T &operator *() const { return *iter; }
+    TokenIterator() {}  // end of any span
 
-    auto check_end() {
-        if(not at_end) {
-            if(iter == last)
-                at_end = true;
-            else {
-                auto t = is->peek();
-                if(t == TIter::traits_type::eof() or t == until)
-                    pre_end = true;
-            }
-        }
+    TokenIterator(const Span &span, const Separators &seps, bool empties) :
+        pos(span.first), last(span.last), seps(&seps), empties(empties) {
+        next();
     }
 
-    istream_iterator_until &operator ++() {
-        if(pre_end)
-            at_end = true;
+    void next() {
+        if(not empties)
+            while(pos != last and (*seps)(*pos))
+                pos++;
 
-        if(not at_end)
-            ++iter;
-        else if(*is)  // at_end and stream is still good skip terminator
-            is->get();
-        check_end();
-
-        return *this;
+        if(pos == last) {
+            pos = nullptr;  // equal to the end iterator
+            return;
+        }
+        auto tend = seps->find(pos, last);
+        token = Span(pos, tend);
+        pos = tend + (empties and tend != last);  // skip the separator
     }
 
-    istream_iterator_until operator ++(int) {
-        istream_iterator_until tmp = *this;
-        if(pre_end)
-            at_end = true;
+    reference operator *() const { return token; }
+    pointer operator ->() const { return &token; }
 
-        if(not at_end)
-            ++(*this);
-        else if(*is)  // at_end and stream is still good skip terminator
-            is->get();
-        check_end();
+    TokenIterator &operator ++() { next(); return *this; }
 
+    TokenIterator operator ++(int) {
+        auto tmp = *this;
+        next();
         return tmp;
     }
 
-    bool operator !=(const istream_iterator_until &other) const {
+    bool operator ==(const TokenIterator &other) const {
+        return pos == other.pos;  // past each token: unique
+    }
+    bool operator !=(const TokenIterator &other) const {
         return not (*this == other);
     }
+};
 
-    bool operator ==(const istream_iterator_until &other) const {
-        if(at_end)
-            return other.at_end;
 
-        if(other.at_end)
-            return false;
+struct TokenRange {
+    Span span;
+    Separators seps;
+    bool empties;
 
-        return iter == other.iter;
-    }
-};
+    TokenRange(const Span &span, const char *seps, bool empties) :
+        span(span), seps(seps), empties(empties) {}
 
+    TokenIterator begin() const { return TokenIterator(span, seps, empties); }
+    TokenIterator end() const { return TokenIterator(); }
+};
 
-///////////////////////////////////////////////////////////////////////////////
-// Stream Imbuer for Parsing
-// http://stackoverflow.com/questions/1894886/parsing-a-comma-delimited-stdstring
-//    ss.imbue(std::locale(ss.getloc(), new SeparatorReader(" ,|")));
-///////////////////////////////////////////////////////////////////////////////
 
-struct SeparatorReader: std::ctype<char>
+// The range keeps the separators: iterators must not outlive it
+inline TokenRange
+tokens(const Span &span, const char *seps, bool empties=false)
 {
-    template<typename T>
-    SeparatorReader(const T &seps): std::ctype<char>(get_table(seps), true) {}
-
-    template<typename T>
-    std::ctype_base::mask const *get_table(const T &seps) {
-        auto &&rc = new std::ctype_base::mask[std::ctype<char>::table_size]();
-        for(auto &&sep: seps)
-            rc[static_cast<unsigned char>(sep)] = std::ctype_base::space;
-        return &rc[0];
+    return TokenRange(span, seps, empties);
+}
+
+
+class InputReader {
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapped = MAP_FAILED;
+    std::vector<char> buffer;  // if it could not be mapped
+
+    static const size_t BLOCKSIZE = 1 << 20;
+
+public:
+    InputReader(const char *path) {
+        auto fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+        if(fd < 0)
+            return;
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped != MAP_FAILED) {
+                madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(mapped);
+                size = st.st_size;
+            }
+        }
+        if(mapped == MAP_FAILED) {
+            for(ssize_t n=1; n > 0; size += n) {
+                buffer.resize(size + BLOCKSIZE);
+                n = read(fd, &buffer[size], BLOCKSIZE);
+                n = std::max<ssize_t>(n, 0);
+            }
+            data = buffer.data();
+        }
+        if(path)
+            close(fd);
     }
+
+    ~InputReader() {
+        if(mapped != MAP_FAILED)
+            munmap(mapped, size);
+    }
+
+    InputReader(const InputReader &) = delete;
+    InputReader &operator =(const InputReader &) = delete;
+
+    Span all() const { return Span(data, data + size); }
+
+    // Lines without the '\n', empty ones included
+    TokenRange lines() const { return tokens(all(), "\n", true); }
 };
 
 
@@ -277,23 +348,141 @@ max_score(std::map<int, int> assigned, std::vector<std::vector<int>> &values)
     return static_cast<float>(maxscore) / 100.0;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Fixed point with precision decimals, formatted by printf like iostream
+// does for std::fixed (same rounding: exact binary value, ties to even)
+struct Fixed {
+    double value;
+    int precision;
+};
+
+
+inline Fixed
+fixed(double value, int precision)
+{
+    return Fixed{value, precision};
+}
+
+
+inline OutputSink &
+operator <<(OutputSink &sink, const Fixed &f)
+{
+    char buf[352];  // DBL_MAX has 309 integer digits
+    auto n = std::snprintf(buf, sizeof(buf), "%.*f", f.precision, f.value);
+    return sink.write(buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
-    std::ifstream stream(argv[1]);
-    stream.imbue(std::locale(stream.getloc(), new SeparatorReader(",;\n")));
+    InputReader reader(argv[1]);
 
-    using isit_until = istream_iterator_until<std::string>;
-    auto slast = isit_until();
+    for(auto &&line: reader.lines()) {
+        // customer,customer;product,product
+        auto semicolon = std::find(line.begin(), line.end(), ';');
+        auto plist = semicolon + (semicolon != line.end());
 
-    while (stream) {
-        auto customers = std::vector<std::string>{};
-        std::copy(isit_until(stream, ';'), slast, std::back_inserter(customers));
+        auto ctokens = tokens(Span(line.begin(), semicolon), ",");
+        auto customers = std::vector<Span>{};
+        std::copy(ctokens.begin(), ctokens.end(), std::back_inserter(customers));
 
-        auto products = std::vector<std::string>{};
-        std::copy(isit_until(stream, '\n'), slast, std::back_inserter(products));
+        auto ptokens = tokens(Span(plist, line.end()), ",");
+        auto products = std::vector<Span>{};
+        std::copy(ptokens.begin(), ptokens.end(), std::back_inserter(products));
 
         auto pbegin = products.begin();
         auto pend = products.end();
@@ -304,7 +493,7 @@ main(int argc, char *argv[]) {
         auto nprods = std::distance(pbegin, pend);  // cols (products) size
 
         if(not ncusts or not nprods) {
-            std::cout << std::fixed << std::setprecision(2) << 0.0 << std::endl;
+            sink << fixed(0.0, 2) << '\n';
             continue;
         }
 
@@ -331,7 +520,7 @@ main(int argc, char *argv[]) {
 
         auto assigned = auction(values);
         auto maxscore = max_score(assigned, values);
-        std::cout << std::fixed << std::setprecision(2) << maxscore << std::endl;
+        sink << fixed(maxscore, 2) << '\n';
     }
     return 0;
 }
@@ -23,31 +23,293 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <numeric>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include <unistd.h>
 
-template<typename TIn, typename TOut>
+
+// Type used to count the subsequences
+//   0: uint64_t
+//   1: 128 bits unsigned integer
+//   2: modulo COUNT_MODULUS (prime)
+//   3: arbitrary precision
+#define COUNT_TYPE 0
+#define COUNT_MODULUS 1000000007
+
+// Counts only need to start at 0 or 1, be added and printed
+
+struct UInt128 {
+    unsigned __int128 v;
+
+    UInt128(uint64_t v=0) : v(v) {}
+
+    UInt128 &operator +=(const UInt128 &other) {
+        v += other.v;
+        return *this;
+    }
+};
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
+OutputSink &
+operator <<(OutputSink &os, const UInt128 &n)
+{
+    char digits[40];
+    auto d = std::end(digits);
+    auto v = n.v;
+    do {
+        *--d = '0' + v % 10;
+        v /= 10;
+    } while(v);
+    return os.write(d, std::distance(d, std::end(digits)));
+}
+
+
+template<uint64_t P>
+struct ModCount {
+    uint64_t v;
+
+    ModCount(uint64_t v=0) : v(v % P) {}
+
+    ModCount &operator +=(const ModCount &other) {
+        v += other.v;  // both < P < 2^63: no overflow
+        if(v >= P)
+            v -= P;
+        return *this;
+    }
+};
+
+template<uint64_t P>
+OutputSink &
+operator <<(OutputSink &os, const ModCount<P> &n)
+{
+    return os << n.v;
+}
+
+
+// Little endian limbs in base 10^9 to make printing trivial
+struct BigUInt {
+    static const uint32_t BASE = 1000000000;
+    std::vector<uint32_t> limbs;
+
+    BigUInt(uint64_t v=0) {
+        do {
+            limbs.push_back(v % BASE);
+            v /= BASE;
+        } while(v);
+    }
+
+    BigUInt &operator +=(const BigUInt &other) {
+        if(limbs.size() < other.limbs.size())
+            limbs.resize(other.limbs.size(), 0);
+
+        uint32_t carry = 0;
+        for(size_t i=0; i < limbs.size(); i++) {
+            if(i >= other.limbs.size() and not carry)
+                break;
+
+            auto sum = limbs[i] + carry;
+            if(i < other.limbs.size())
+                sum += other.limbs[i];
+
+            carry = sum >= BASE;
+            limbs[i] = sum - carry * BASE;
+        }
+        if(carry)
+            limbs.push_back(carry);
+
+        return *this;
+    }
+};
+
+OutputSink &
+operator <<(OutputSink &os, const BigUInt &n)
+{
+    auto l = n.limbs.rbegin();
+    os << *l;
+
+    for(++l; l != n.limbs.rend(); ++l) {
+        char digits[9];  // zero padded
+        auto v = *l;
+        for(auto d=std::end(digits); d != std::begin(digits); v /= 10)
+            *--d = '0' + v % 10;
+        os.write(digits, sizeof(digits));
+    }
+    return os;
+}
+
+
+#if COUNT_TYPE == 0
+using Count = uint64_t;
+#elif COUNT_TYPE == 1
+using Count = UInt128;
+#elif COUNT_TYPE == 2
+using Count = ModCount<COUNT_MODULUS>;
+#else
+using Count = BigUInt;
+#endif
+
+
+// r0[i] (matches of b[0..i) in a[0..j)) only changes in row j if b[i - 1]
+// equals a[j]: r0[i] += r0[i - 1]. Updating only those positions from right
+// to left (r0[i - 1] still belongs to the previous row) makes the cost
+// proportional to the number of matches and not to |a| * |b|
+template<typename T, typename TIn, typename TOut>
 auto
 distinct_subsequences(TIn a1, TIn a2, TIn b1, TIn b2, TOut out)
 {
-    // calculate row size (make room for initial left value)
+    // Index of positions of each char in b (1 based to leave room for the
+    // leftmost value), in descending order and grouped by char
+    size_t offsets[UCHAR_MAX + 2] = {0};
+    for(auto pb=b1; pb != b2; pb++)
+        offsets[static_cast<unsigned char>(*pb) + 1]++;
+
+    std::partial_sum(std::begin(offsets), std::end(offsets),
+                     std::begin(offsets));
+
     auto colsize = std::distance(b1, b2) + 1;
+    auto positions = std::vector<size_t>(colsize - 1);
+    auto fill = std::vector<size_t>(std::begin(offsets), std::end(offsets));
+    for(auto i=colsize - 1; i > 0; i--)
+        positions[fill[static_cast<unsigned char>(*std::next(b1, i - 1))]++] = i;
 
-    // initialize operation row and cache row
-    auto r0 = std::vector<unsigned int>(colsize, 0);
+    // initialize operation row: leftmost value (empty b) is always 1
+    auto r0 = std::vector<T>(colsize, T(0));
+    r0[0] = T(1);
 
+    auto pbegin = positions.cbegin();
     for(auto pa=a1; pa != a2; pa++) {
-        auto &a = *pa;
-
-        auto r0j1 = r0[0] = 1;  // cache current leftmost value
-        auto i = 1;  // skip leftmost init value (colsize is 1 longer)
-        for(auto pb=b1; pb != b2; pb++, i++) {
-            auto cache = r0[i];
-            r0[i] += r0j1 * (a == *pb);
-            r0j1 = cache;
-        }
+        auto c = static_cast<unsigned char>(*pa);
+        auto p2 = std::next(pbegin, offsets[c + 1]);
+        for(auto p=std::next(pbegin, offsets[c]); p != p2; p++)
+            r0[*p] += r0[*p - 1];
     }
     *out++ = r0.back();  // send to output iterator
 }
@@ -60,7 +322,7 @@ distinct_subsequences(TIn a1, TIn a2, TIn b1, TIn b2, TOut out)
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
-    auto out = std::ostream_iterator<int>(std::cout, "\n");
+    auto out = SinkIterator<Count>(sink, "\n");
 
     std::string line;
     while (std::getline(stream, line)) {
@@ -68,7 +330,7 @@ main(int argc, char *argv[]) {
         auto seppos = line.find_first_of(",");
         auto lbegin = line.begin();
 
-        distinct_subsequences(
+        distinct_subsequences<Count>(
             lbegin, std::next(lbegin, seppos),            // String A
             std::next(lbegin, seppos + 1), line.end(),    // String B
             out);                                         // Output
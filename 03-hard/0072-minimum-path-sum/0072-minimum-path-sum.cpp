@@ -31,64 +31,361 @@
 // Headers for test case input
 #include <fstream>
 #include <iostream>
-#include <string>
 
 
 // Headers for the implementation
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <limits>
-#include <memory>
-#include <sstream>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include <unistd.h>
+
 
 ///////////////////////////////////////////////////////////////////////////////
-// Stream Imbuer for Parsing
+// Integer Reader
 ///////////////////////////////////////////////////////////////////////////////
-struct csv_reader: std::ctype<char> {
-    csv_reader(): std::ctype<char>(get_table()) {}
-    static std::ctype_base::mask const* get_table() {
-        static std::vector<std::ctype_base::mask> rc(table_size, std::ctype_base::mask());
-
-        rc[','] = std::ctype_base::space;
-        rc['\n'] = std::ctype_base::space;
-        rc[' '] = std::ctype_base::space;
-        return &rc[0];
+
+// Reads non-negative integers from large blocks of the stream skipping any
+// separator (',', ' ', '\n', ...) in between instead of going through the
+// locale/ctype machinery char by char. Only 1 block is kept in memory
+struct IntReader {
+    static const size_t BLOCKSIZE = 1 << 16;
+
+    std::istream &is;
+    std::vector<char> buf;
+    const char *cur;
+    const char *end;
+    std::streamoff base = 0;  // stream position of buf[0]
+
+    explicit IntReader(std::istream &is) :
+        is(is), buf(BLOCKSIZE), cur(buf.data()), end(buf.data()) {}
+
+    bool fill() {
+        base += std::distance<const char *>(buf.data(), end);
+        auto got = is.rdbuf()->sgetn(buf.data(), buf.size());
+        cur = buf.data();
+        end = cur + got;
+        return got > 0;
+    }
+
+    std::streamoff tell() const {
+        return base + std::distance<const char *>(buf.data(), cur);
+    }
+
+    void seek(std::streamoff pos) {
+        is.rdbuf()->pubseekpos(pos);
+        base = pos;
+        cur = end = buf.data();
+    }
+
+    bool next(int64_t &val) {
+        for(;; cur++) {  // skip separators
+            if(cur == end and not fill())
+                return false;
+            if(static_cast<unsigned char>(*cur - '0') < 10)
+                break;
+        }
+
+        val = 0;
+        for(;; cur++) {
+            if(cur == end and not fill())
+                return true;  // number ended with the input
+            auto digit = static_cast<unsigned char>(*cur - '0');
+            if(digit >= 10)
+                return true;
+            val = 10 * val + digit;
+        }
     }
 };
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Row update
+///////////////////////////////////////////////////////////////////////////////
+
+// Large enough not to be reached and small enough to be operated on without
+// overflowing
+const int64_t INF = std::numeric_limits<int64_t>::max() / 4;
+
+// r[j] = min(r[j - 1], rprev[j]) + v[j] carries a dependency through the row.
+// With S[j] the prefix sums of v it is equivalent to:
+//
+//   r[j] = S[j] + min(rprev[i] - S[i - 1]) for i <= j
+//
+// i.e.: a prefix sum, a vertical (element wise) operation and a prefix min,
+// both scans being done in log steps inside a SIMD register
+void
+row_update(int64_t *r, const int64_t *v, size_t n)
+{
+    size_t j = 0;
+    int64_t sum = 0;
+    int64_t best = INF;
+
+#ifdef __AVX2__
+    // Shift 1/2 lanes towards the high end filling with the given value
+    auto shift1 = [](__m256i x, __m256i fill) {
+        auto p = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0));
+        return _mm256_blend_epi32(p, fill, 0x03);
+    };
+    auto shift2 = [](__m256i x, __m256i fill) {
+        auto p = _mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0));
+        return _mm256_blend_epi32(p, fill, 0x0F);
+    };
+    auto min64 = [](__m256i a, __m256i b) {
+        return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    };
+    auto last = [](__m256i x) {  // broadcast the highest lane
+        return _mm256_permute4x64_epi64(x, _MM_SHUFFLE(3, 3, 3, 3));
+    };
+
+    auto zero = _mm256_setzero_si256();
+    auto inf = _mm256_set1_epi64x(INF);
+    auto vsum = zero;
+    auto vbest = inf;
+
+    for(; j + 4 <= n; j += 4) {
+        auto vv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(v + j));
+        auto vr = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(r + j));
+
+        auto s = _mm256_add_epi64(vv, shift1(vv, zero));
+        s = _mm256_add_epi64(s, shift2(s, zero));
+        s = _mm256_add_epi64(s, vsum);
+
+        auto t = _mm256_add_epi64(_mm256_sub_epi64(vr, s), vv);  // vertical
+        t = min64(t, shift1(t, inf));
+        t = min64(t, shift2(t, inf));
+        t = min64(t, vbest);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(r + j),
+                            _mm256_add_epi64(s, t));
+        vsum = last(s);
+        vbest = last(t);
+    }
+    sum = _mm256_extract_epi64(vsum, 0);
+    best = _mm256_extract_epi64(vbest, 0);
+#endif
+
+    for(; j < n; j++) {
+        sum += v[j];
+        best = std::min(best, r[j] - sum + v[j]);
+        r[j] = sum + best;
+    }
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Path
+///////////////////////////////////////////////////////////////////////////////
+
+// Set to 1 to also print the path as the moves taken from the top left cell
+// (R: right, D: down)
+#define PATH 0
+
+// Only every c-th (c = sqrt(m)) row of results is kept during the forward
+// pass, together with the input position of the values of the next row. The
+// path is recovered bottom up: the rows between two checkpoints are
+// recomputed from the first one re-reading the input and walked backwards.
+// Memory is O(n sqrt(m)) for about twice the computation
+std::string
+min_path(IntReader &reader, int64_t msize, int64_t &cost)
+{
+    auto vals = std::vector<int64_t>(msize);
+    auto c = static_cast<int64_t>(std::ceil(std::sqrt(msize)));
+
+    // checkpoint k: results of row k * c - 1 and input position of row k * c
+    auto r0 = std::vector<int64_t>(msize, INF);
+    r0[0] = 0;  // top left can only be entered from "above"
+    auto checkpoints = std::vector<std::vector<int64_t>>();
+    auto offsets = std::vector<std::streamoff>();
+
+    for(auto m=0; m < msize; m++) {
+        if(not (m % c)) {
+            checkpoints.push_back(r0);
+            offsets.push_back(reader.tell());
+        }
+        for(auto &&val: vals)
+            reader.next(val);
+
+        row_update(r0.data(), vals.data(), msize);
+    }
+    cost = r0[msize - 1];
+    auto endpos = reader.tell();
+
+    auto moves = std::string();
+    auto segment = std::vector<std::vector<int64_t>>(c);
+    auto j = msize - 1;
+    for(auto k=checkpoints.size(); k--;) {
+        auto first = k * c;
+        auto rows = std::min<int64_t>(c, msize - first);
+
+        reader.seek(offsets[k]);
+        r0 = checkpoints[k];
+        for(auto i=0; i < rows; i++) {
+            for(auto &&val: vals)
+                reader.next(val);
+
+            row_update(r0.data(), vals.data(), msize);
+            segment[i] = r0;
+        }
+
+        // Walk from the last row up to the checkpoint. Leaving through the
+        // checkpoint from column 0 of the first row is the start
+        for(auto i=rows - 1; i >= 0;) {
+            auto &cur = segment[i];
+            auto &prev = i ? segment[i - 1] : checkpoints[k];
+            if(j and cur[j - 1] < prev[j]) {
+                moves.push_back('R');
+                j--;
+            } else {
+                if(first + i)  // not the start
+                    moves.push_back('D');
+                i--;
+            }
+        }
+    }
+    reader.seek(endpos);  // leave the reader after this test case
+
+    std::reverse(moves.begin(), moves.end());
+    return moves;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
-    std::string line;
-
-    // Imbue ss to parse csv automatically
-    std::stringstream ss;
-    ss.imbue(std::locale(std::locale(), new csv_reader()));
-
-    const size_t inf = std::numeric_limits<size_t>::max();
+    auto reader = IntReader(stream);
 
-    while(std::getline(stream, line)) {
-        // Do something with the line
-        auto msize = std::stoi(line) + 1;  // input size + 1 col/row extension
+    // Only 1 row of values and 1 of results are kept in memory
+    auto vals = std::vector<int64_t>();
+    auto r0 = std::vector<int64_t>();
 
-        // Initialize row
-        auto r0 = std::vector<size_t>(msize, inf);
+    int64_t msize;
+    while(reader.next(msize)) {
+#if PATH
+        int64_t cost;
+        auto moves = min_path(reader, msize, cost);
+        sink << cost << ' ' << moves << '\n';
+        continue;
+#endif
+        // The top left cell can only be entered from "above"
+        r0.assign(msize, INF);
+        r0[0] = 0;
+        vals.resize(msize);
 
         // Loop m rows
-        for(auto m=1; m < msize; m++) {
-            std::getline(stream, line);
-            ss.str(line); ss.clear();  // Must be cleared because it was eol (eof)
-            // Loop n cols
-            for(size_t n=1, val=0, cache=(m - 1) ? inf : 0; ss >> val; n++) {
-                r0[n] = cache = std::min(cache, r0[n]) + val;
-            }
+        for(auto m=0; m < msize; m++) {
+            for(auto &&val: vals)
+                reader.next(val);
+
+            row_update(r0.data(), vals.data(), msize);
         }
         // Minimum Path Sum is in the last row/col
-        std::cout << r0[msize - 1] << std::endl;
+        sink << r0[msize - 1] << '\n';
     }
     return 0;
 }
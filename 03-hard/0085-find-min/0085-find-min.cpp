@@ -23,9 +23,18 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <future>
 #include <iterator>
+#include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <unistd.h>
+
 
 struct SeparatorReader: std::ctype<char>
 {
@@ -41,70 +50,261 @@ struct SeparatorReader: std::ctype<char>
     }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Solver
+///////////////////////////////////////////////////////////////////////////////
+
+// The values not present in the window (only 0..k matter, because k values
+// cannot hide a smaller minimum) as a bitset. A summary with one bit per
+// non-empty word lets the minimum be found scanning k / 4096 words
+struct FreeSet {
+    std::vector<uint64_t> words;
+    std::vector<uint64_t> summary;
+
+    void reset(size_t size) {  // all of [0, size) free
+        words.assign((size + 63) / 64, 0);
+        summary.assign((words.size() + 63) / 64, 0);
+        for(size_t v=0; v < size; v++)
+            give(v);
+    }
+
+    void take(size_t v) {
+        auto &w = words[v / 64];
+        w &= ~(uint64_t(1) << v % 64);
+        if(not w)
+            summary[v / 4096] &= ~(uint64_t(1) << v / 64 % 64);
+    }
+
+    void give(size_t v) {
+        words[v / 64] |= uint64_t(1) << v % 64;
+        summary[v / 4096] |= uint64_t(1) << v / 64 % 64;
+    }
+
+    size_t min() const {
+        auto s = std::find_if(summary.cbegin(), summary.cend(),
+                              [](uint64_t x) { return x != 0; });
+        auto w = std::distance(summary.cbegin(), s) * 64 + __builtin_ctzll(*s);
+        return w * 64 + __builtin_ctzll(words[w]);
+    }
+};
+
+
+// From m[k] on each window of k + 1 values is a permutation of 0..k: the
+// value leaving the window is the only one which can be missing next. The
+// sequence is periodic with period k + 1 and only m[0] .. m[2k] is needed
+template <typename T>
+T
+find_min(long n, long k, long a, long b, long c, long r,
+         std::vector<T> &ks, std::vector<T> &counts, FreeSet &frees)
+{
+    auto l = k + 1;
+    auto last = std::min(n, k + l);
+
+    std::fill_n(counts.begin(), l, 0);  // zero the needed maximum
+
+    long long m;
+    ks[0] = m = a % r;  // init value
+    for(auto i=1; i < k; i++)  // init 1st k values
+        ks[i] = m = (b * m + c) % r;
+
+    frees.reset(l);
+    for(auto i=0; i < k; i++) {
+        auto v = ks[i];
+        if(v < l and not counts[v]++)  // do only count if in target range
+            frees.take(v);
+    }
+
+    for(auto i=k; i < last; i++) {  // slide the window
+        auto mnni = ks[i] = frees.min();
+        counts[mnni]++;
+        frees.take(mnni);
+        auto oow = ks[i - k];
+        if(oow < l and not --counts[oow])  // do not update for too large
+            frees.give(oow);
+    }
+
+    if(n <= last)
+        return ks[n - 1];
+
+    return ks[k + (n - k - 1) % l];
+}
+
+
+struct TestCase {
+    uint32_t n, k, a, b, c, r;
+};
+
+
+// Solve the test cases on a pool of threads, each one with its own scratch
+// buffers. The cases are taken one at a time (their cost depends on k) and
+// the results stored at the index of the case to keep the input order
+std::vector<unsigned int>
+find_min_all(const std::vector<TestCase> &tests, uint32_t maxk)
+{
+    auto results = std::vector<unsigned int>(tests.size());
+    std::atomic<size_t> next(0);
+
+    auto worker = [&]() {
+        auto ks = std::vector<unsigned int>(2 * maxk + 1);
+        auto counts = std::vector<unsigned int>(maxk + 1, 0);
+        auto frees = FreeSet();
+
+        for(size_t i; (i = next++) < tests.size();) {
+            auto &t = tests[i];
+            results[i] = find_min(t.n, t.k, t.a, t.b, t.c, t.r,
+                                  ks, counts, frees);
+        }
+    };
+
+    auto nthreads = std::min<size_t>(std::thread::hardware_concurrency(),
+                                     tests.size());
+    std::vector<std::future<void>> futs;
+    for(size_t t=1; t < nthreads; t++)
+        futs.push_back(std::async(std::launch::async, worker));
+
+    worker();  // the main thread is also part of the pool
+    for(auto &&fut: futs)
+        fut.get();
+
+    return results;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 
 // if optimize is 0 then ala Formula 1, the test cases will be used as key to
-// determine how to minimize memory allocation by 1st scanning the input file
-// to determine the maximum "n" and "k" and allocate the vector only once with
-// this maximum values
+// determine how to minimize memory allocation by 1st parsing the whole input
+// file (only once) to determine the maximum "k" and allocate the buffers only
+// once with this maximum values
 
 // The testcases are later executed with the actual values but without
-// reallocating memory, simply restricting indices to the n, k values
+// reallocating memory, simply restricting indices to the n, k values. Being
+// independent of each other, they are solved in parallel
 
 #define OPTIMIZE 1
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
     stream.imbue(std::locale(stream.getloc(), new SeparatorReader(",\n")));
 
-    int m, n, k, a, b, c, r;
 #if OPTIMIZE
-    int maxn = 0, maxk = 0;
-    while(stream >> n >> k >> a >> b >> c >> r) {
-        maxn = std::max(maxn, n);
-        maxk = std::max(maxk, k);
-    }
-    stream.clear();
-    stream.seekg(0);
+    auto tests = std::vector<TestCase>();
+    uint32_t maxk = 0;
 
-    auto ks = std::vector<unsigned short>(maxn);
-    auto counts = std::vector<unsigned short>(maxk, 0);
-    auto cbegin = counts.begin();
-#endif
+    TestCase t;
+    while(stream >> t.n >> t.k >> t.a >> t.b >> t.c >> t.r) {
+        tests.push_back(t);
+        maxk = std::max(maxk, t.k);
+    }
 
-    while(stream >> n >> k >> a >> b >> c >> r) {
-        auto l = k + 1;
-#if not OPTIMIZE
-        auto ks = std::vector<unsigned short>(std::max(n, maxn));
-        auto counts = std::vector<unsigned short>(l, 0);
-        auto cbegin = counts.cbegin();
+    for(auto &&result: find_min_all(tests, maxk))
+        sink << result << '\n';
 #else
-        std::fill_n(cbegin, l, 0);  // zero the needed maximum
-#endif
-        auto cend = std::next(cbegin, l);  // do not look beyond needed max
-
-        ks[0] = m = a % r;  // init value
-        if(m < l)
-            counts[m]++;  // do only count if within target range
+    long n, k, a, b, c, r;
+    auto frees = FreeSet();
 
-        for(auto i=1; i < k; i++) {  // init 1st k values
-            ks[i] = m = (b * m + c) % r;
-            if(m < l)
-                counts[m]++;  // do only count if in target range
-        }
-
-        for(auto i=k, oow=0, mnni=0; i < n; i++) {  // slide the window
-            ks[i] = mnni = std::distance(cbegin, std::find(cbegin, cend, 0));
-            counts[mnni]++;
-            oow = ks[i - k];
-            if(oow < l)
-                counts[oow]--;  // do not update for too large never to be seen again
-        }
-        std::cout << ks[n - 1] << std::endl;
+    while(stream >> n >> k >> a >> b >> c >> r) {
+        auto ks = std::vector<unsigned int>(2 * k + 1);
+        auto counts = std::vector<unsigned int>(k + 1, 0);
+        sink << find_min(n, k, a, b, c, r, ks, counts, frees) << '\n';
     }
+#endif
 
     return 0;
 }
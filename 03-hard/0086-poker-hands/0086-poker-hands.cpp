@@ -23,10 +23,22 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <future>
 #include <iterator>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+#include <unistd.h>
+
 
 // Version which removes most of C++ 11 (and even non C++ 11 but STL) things to
 // try to decrease compilations times and get over the 10sec compilation
@@ -36,6 +48,10 @@
 // CodeEval feedback site and suddenly C++ compiles
 
 
+// Input whose first line has a '|' holds partially dealt hands: win/tie/loss
+// odds are estimated for them instead of comparing complete hands (see
+// equity_main below for the input format)
+
 const auto NUMCARDS = 5;
 
 const auto SCORE_STRAIGHT_FLUSH = 8000000;
@@ -51,6 +67,123 @@ const auto SCORE_HIGH_CARD = 0;
 const static std::string DECK{"23456789TJQKA"};
 const static std::string DECK_STRAIGHT{"2345A23456789TJQKA"};
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Fixed point with precision decimals, formatted by printf like iostream
+// does for std::fixed (same rounding: exact binary value, ties to even)
+struct Fixed {
+    double value;
+    int precision;
+};
+
+
+inline Fixed
+fixed(double value, int precision)
+{
+    return Fixed{value, precision};
+}
+
+
+inline OutputSink &
+operator <<(OutputSink &sink, const Fixed &f)
+{
+    char buf[352];  // DBL_MAX has 309 integer digits
+    auto n = std::snprintf(buf, sizeof(buf), "%.*f", f.precision, f.value);
+    return sink.write(buf, std::min<size_t>(n, sizeof(buf) - 1));
+}
+
+
+OutputSink sink;  // flushed at exit
+
+
 int
 hand_eval(const char hand[NUMCARDS][2])
 {
@@ -130,6 +263,328 @@ hand_eval(const char hand[NUMCARDS][2])
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Equity
+///////////////////////////////////////////////////////////////////////////////
+
+// Cards are bit indices in a 64-bit deck mask: suit * 13 + face value
+const auto DECKSIZE = 52;
+const uint64_t FULLDECK = (uint64_t(1) << DECKSIZE) - 1;
+const static std::string SUITS{"CDHS"};
+
+// If exploring all the deals is cheaper than the requested number of trials
+// the equity is calculated exactly
+const uint64_t EQUITY_TRIALS = 1000000;
+const uint64_t EQUITY_SEED = 0x5eed;
+
+// Monte Carlo trials are split in a fixed number of random streams (shared out
+// amongst the threads) for the results not to depend on the number of cores
+const uint64_t EQUITY_STREAMS = 64;
+
+
+struct PartialHand {
+    char cards[NUMCARDS][2];
+    int known = 0;  // cards [0, known) were given, the rest are dealt
+};
+
+
+struct Equity {
+    uint64_t left = 0;
+    uint64_t none = 0;
+    uint64_t right = 0;
+
+    uint64_t total() const { return left + none + right; }
+
+    Equity &operator +=(const Equity &other) {
+        left += other.left;
+        none += other.none;
+        right += other.right;
+        return *this;
+    }
+};
+
+
+// xoshiro256** from Blackman/Vigna: http://prng.di.unimi.it/
+// Each stream of trials starts 2^128 steps ahead of the previous one
+struct Xoshiro256 {
+    uint64_t s[4];
+
+    explicit Xoshiro256(uint64_t seed) {
+        for(auto &x: s) {  // splitmix64 to expand the seed
+            auto z = (seed += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            x = z ^ (z >> 31);
+        }
+    }
+
+    static uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t operator ()() {
+        auto result = rotl(s[1] * 5, 7) * 9;
+        auto t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+    void jump() {
+        static const uint64_t JUMP[] = {
+            0x180ec6d33cfd0aba, 0xd5a61266f0c9392c,
+            0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+
+        uint64_t t[4] = {0, 0, 0, 0};
+        for(auto &&j: JUMP) {
+            for(int b=0; b < 64; b++) {
+                if(j & uint64_t(1) << b)
+                    for(int i=0; i < 4; i++)
+                        t[i] ^= s[i];
+                (*this)();
+            }
+        }
+        std::copy(t, t + 4, s);
+    }
+};
+
+
+// -1 for a malformed card
+inline int
+card_index(const char card[2])
+{
+    auto suit = SUITS.find(card[1]);
+    auto face = DECK.find(card[0]);
+    if(suit == std::string::npos or face == std::string::npos)
+        return -1;
+    return suit * DECK.size() + face;
+}
+
+inline void
+card_deal(char card[2], int index)
+{
+    card[0] = DECK[index % DECK.size()];
+    card[1] = SUITS[index / DECK.size()];
+}
+
+inline void
+showdown(const PartialHand &lhand, const PartialHand &rhand, Equity &equity)
+{
+    int lscore = hand_eval(lhand.cards);
+    int rscore = hand_eval(rhand.cards);
+    equity.left += lscore > rscore;
+    equity.none += lscore == rscore;
+    equity.right += rscore > lscore;
+}
+
+uint64_t
+binomial(uint64_t n, uint64_t k)
+{
+    uint64_t r = 1;
+    for(uint64_t i=1; i <= k; i++)
+        r = r * (n - k + i) / i;  // exact: r is C(n - k + i, i) after the step
+    return r;
+}
+
+
+Equity
+equity_montecarlo(PartialHand lhand, PartialHand rhand, uint64_t deck,
+                  Xoshiro256 rng, uint64_t trials)
+{
+    Equity equity;
+    PartialHand *hands[2] = {&lhand, &rhand};
+
+    for(uint64_t t=0; t < trials; t++) {
+        auto avail = deck;
+        for(auto hand: hands) {
+            for(int i=hand->known; i < NUMCARDS; i++) {
+                // Top 6 bits: reject values past the deck or already dealt
+                int index;
+                do
+                    index = rng() >> 58;
+                while(index >= DECKSIZE or not (avail >> index & 1));
+
+                avail &= ~(uint64_t(1) << index);
+                card_deal(hand->cards[i], index);
+            }
+        }
+        showdown(lhand, rhand, equity);
+    }
+    return equity;
+}
+
+
+// Slots [0, NUMCARDS) belong to the left hand and the rest to the right hand.
+// The cards of a hand are dealt in increasing index order to produce each
+// combination only once
+void
+equity_enumerate(PartialHand &lhand, PartialHand &rhand, uint64_t avail,
+                 int slot, int from, Equity &equity)
+{
+    if(slot == 2 * NUMCARDS) {
+        showdown(lhand, rhand, equity);
+        return;
+    }
+
+    if(slot == NUMCARDS)
+        from = 0;  // start combinations again for the right hand
+
+    auto &hand = slot < NUMCARDS ? lhand : rhand;
+    auto pos = slot % NUMCARDS;
+    if(pos < hand.known) {
+        equity_enumerate(lhand, rhand, avail, slot + 1, from, equity);
+        return;
+    }
+
+    for(auto m = avail & (~uint64_t(0) << from); m; m &= m - 1) {
+        auto index = __builtin_ctzll(m);
+        card_deal(hand.cards[pos], index);
+        equity_enumerate(lhand, rhand, avail & ~(uint64_t(1) << index),
+                         slot + 1, index + 1, equity);
+    }
+}
+
+
+// Deck without the given cards or 0 if a card is malformed or repeated
+uint64_t
+deck_left(const PartialHand &lhand, const PartialHand &rhand)
+{
+    auto deck = FULLDECK;
+    for(auto &&hand: {&lhand, &rhand})
+        for(int i=0; i < hand->known; i++) {
+            auto index = card_index(hand->cards[i]);
+            if(index < 0 or not (deck >> index & 1))
+                return 0;
+            deck &= ~(uint64_t(1) << index);
+        }
+    return deck;
+}
+
+
+// The cards of the hands must be valid (see deck_left)
+Equity
+equity(PartialHand lhand, PartialHand rhand, uint64_t trials)
+{
+    auto deck = deck_left(lhand, rhand);
+
+    uint64_t decksize = __builtin_popcountll(deck);
+    uint64_t lmissing = NUMCARDS - lhand.known;
+    uint64_t rmissing = NUMCARDS - rhand.known;
+    auto deals = binomial(decksize, lmissing) *
+        binomial(decksize - lmissing, rmissing);
+
+    Equity equity;
+    if(deals <= trials) {
+        equity_enumerate(lhand, rhand, deck, 0, 0, equity);
+        return equity;
+    }
+
+    auto rngs = std::vector<Xoshiro256>();
+    auto rng = Xoshiro256(EQUITY_SEED);
+    for(uint64_t i=0; i < EQUITY_STREAMS; i++) {
+        rngs.push_back(rng);
+        rng.jump();
+    }
+
+    auto results = std::vector<Equity>(EQUITY_STREAMS);
+    std::atomic<uint64_t> next(0);
+    auto worker = [&]() {
+        for(uint64_t i; (i = next++) < EQUITY_STREAMS;) {
+            auto strials = trials / EQUITY_STREAMS;
+            strials += i < trials % EQUITY_STREAMS;
+            results[i] = equity_montecarlo(lhand, rhand, deck, rngs[i],
+                                           strials);
+        }
+    };
+
+    uint64_t nthreads = std::max(1u, std::thread::hardware_concurrency());
+    nthreads = std::min(nthreads, EQUITY_STREAMS);
+    std::vector<std::future<void>> futs;
+    for(uint64_t t=0; t < nthreads; t++)
+        futs.push_back(std::async(std::launch::async, worker));
+
+    for(auto &&fut: futs)
+        fut.get();
+
+    for(auto &&result: results)
+        equity += result;
+
+    return equity;
+}
+
+
+// Input lines: left cards | right cards [| trials]
+// Output: left/none/right fractions and the evaluation rate to stderr.
+// "invalid cards" for malformed or repeated cards or a hand without cards or
+// with more than NUMCARDS, "invalid trials" unless trials is a positive number
+void
+equity_main(std::istream &stream)
+{
+    std::string line;
+    while(std::getline(stream, line)) {
+        std::replace(line.begin(), line.end(), '|', '\n');
+        std::istringstream ss(line);
+
+        PartialHand hands[2];
+        auto sized = true;  // 1 to NUMCARDS cards in each hand
+        for(auto &&hand: hands) {
+            std::string part;
+            std::getline(ss, part);
+            std::istringstream cards(part);
+            std::string card;
+            while(cards >> card) {
+                if(hand.known == NUMCARDS) {
+                    sized = false;
+                    break;
+                }
+                if(card.size() != 2)
+                    card = "??";  // rejected below
+                hand.cards[hand.known][0] = card[0];
+                hand.cards[hand.known++][1] = card[1];
+            }
+            sized = sized and hand.known;
+        }
+        if(not sized or not deck_left(hands[0], hands[1])) {
+            sink << "invalid cards\n";
+            continue;
+        }
+
+        auto trials = EQUITY_TRIALS;
+        std::string field;
+        if(ss >> field) {
+            // signed: ">>" to an unsigned would wrap "-5" around
+            long long count = 0;
+            std::istringstream fs(field);
+            if(not (fs >> count) or not fs.eof() or count <= 0) {
+                sink << "invalid trials\n";
+                continue;
+            }
+            trials = count;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto eq = equity(hands[0], hands[1], trials);
+        std::chrono::duration<double> secs =
+            std::chrono::steady_clock::now() - start;
+
+        double total = eq.total();
+        sink << "left " << fixed(eq.left / total, 4)
+             << " none " << fixed(eq.none / total, 4)
+             << " right " << fixed(eq.right / total, 4) << '\n';
+
+        std::cerr << eq.total() << " hands in " << secs.count() << "s: "
+                  << static_cast<uint64_t>(eq.total() / secs.count())
+                  << " hands/s\n";
+    }
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
@@ -137,6 +592,16 @@ hand_eval(const char hand[NUMCARDS][2])
 int
 main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
+
+    std::string first;
+    std::getline(stream, first);
+    stream.clear();
+    stream.seekg(0);
+    if(first.find('|') != std::string::npos) {
+        equity_main(stream);
+        return 0;
+    }
+
     std::istream_iterator<char> in1(stream);
 
     const char *results[3] = {"right", "none", "left"};
@@ -162,7 +627,7 @@ main(int argc, char *argv[]) {
         int cmped = (lscore > rscore) - (rscore > lscore);
 
         // print the string
-        std::cout << results[cmped + 1] << std::endl;
+        sink << results[cmped + 1] << '\n';
     }
 
     return 0;
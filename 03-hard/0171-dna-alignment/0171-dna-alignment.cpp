@@ -23,80 +23,200 @@
 #include <algorithm>
 #include <iterator>
 #include <limits>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Stream Imbuer for Parsing
-// http://stackoverflow.com/questions/1894886/parsing-a-comma-delimited-stdstring
-//    ss.imbue(std::locale(ss.getloc(), new SeparatorReader(" ,|")));
+// Zero-copy Input Reader
+//
+// The whole input is mapped (or read in large blocks if it cannot be mapped,
+// like a pipe) and lines/tokens are handed out as spans pointing into it.
+//
+//   InputReader reader(argv[1]);
+//   for(auto &&line: reader.lines())
+//       for(auto &&token: tokens(line, " ,|"))
+//           std::copy(token.begin(), token.end(), out);
 ///////////////////////////////////////////////////////////////////////////////
+struct Span {
+    const char *first = nullptr;
+    const char *last = nullptr;
+
+    Span() {}
+    Span(const char *first, const char *last) : first(first), last(last) {}
+
+    const char *begin() const { return first; }
+    const char *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    char operator [](size_t i) const { return first[i]; }
+    std::string str() const { return std::string(first, last); }
+};
 
-struct SeparatorReader: std::ctype<char>
-{
-    template<typename T>
-    SeparatorReader(const T &seps): std::ctype<char>(get_table(seps), true) {}
 
-    template<typename T>
-    std::ctype_base::mask const *get_table(const T &seps) {
-        auto &&rc = new std::ctype_base::mask[std::ctype<char>::table_size]();
-        for(auto &&sep: seps)
-            rc[static_cast<unsigned char>(sep)] = std::ctype_base::space;
-        return &rc[0];
+// Set of separators for the tokens
+struct Separators {
+    bool table[256] = {};
+    int single = -1;  // only one separator: searched for with memchr
+
+    Separators(const char *seps) {
+        auto n = 0;
+        for(; *seps; seps++, n++)
+            table[static_cast<unsigned char>(*seps)] = true;
+        if(n == 1)
+            single = static_cast<unsigned char>(seps[-1]);
+    }
+
+    bool operator ()(char c) const {
+        return table[static_cast<unsigned char>(c)];
+    }
+
+    // First separator in [first, last) or last
+    const char *find(const char *first, const char *last) const {
+        if(single >= 0) {
+            auto p = std::memchr(first, single, last - first);
+            return p ? static_cast<const char *>(p) : last;
+        }
+        while(first != last and not table[static_cast<unsigned char>(*first)])
+            first++;
+        return first;
     }
 };
 
-///////////////////////////////////////////////////////////////////////////////
-// Iterator which iterates a wrapped istream_iterator until a given character
-///////////////////////////////////////////////////////////////////////////////
 
-template <typename T>
-struct istream_iterator_until {
-    std::istream_iterator<T> iter;
-    std::istream_iterator<T> last;
-    T until;
-    bool at_end;
+// Splits a span at the separators, skipping empty tokens (like the stream
+// does with whitespace) unless empties is set (like getline does with lines)
+struct TokenIterator {
+    const char *pos = nullptr;
+    const char *last = nullptr;
+    const Separators *seps = nullptr;
+    bool empties = false;
+    Span token;
 
-    using value_type = T;
+    using value_type = Span;
     using difference_type = std::ptrdiff_t;
-    using pointer = T *;
-    using reference = T &;
-    using iterator_category = std::output_iterator_tag;
+    using pointer = const Span *;
+    using reference = const Span &;
+    using iterator_category = std::forward_iterator_tag;
 
-    istream_iterator_until() : at_end(true) {}
+    TokenIterator() {}  // end of any span
 
-    istream_iterator_until(std::istream &is, const T &until) :
-        iter(is), last(), until(until), at_end(not is or *iter == until) {}
+    TokenIterator(const Span &span, const Separators &seps, bool empties) :
+        pos(span.first), last(span.last), seps(&seps), empties(empties) {
+        next();
+    }
 
-    T operator *() const { return *iter; }
+    void next() {
+        if(not empties)
+            while(pos != last and (*seps)(*pos))
+                pos++;
 
-    istream_iterator_until& operator ++() {
-        ++iter;
-        at_end = iter == last or *iter == until;
-        return *this;
+        if(pos == last) {
+            pos = nullptr;  // equal to the end iterator
+            return;
+        }
+        auto tend = seps->find(pos, last);
+        token = Span(pos, tend);
+        pos = tend + (empties and tend != last);  // skip the separator
     }
 
-    istream_iterator_until operator ++(int) {
-        istream_iterator_until tmp = *this;
-        ++(*this);
+    reference operator *() const { return token; }
+    pointer operator ->() const { return &token; }
+
+    TokenIterator &operator ++() { next(); return *this; }
+
+    TokenIterator operator ++(int) {
+        auto tmp = *this;
+        next();
         return tmp;
     }
 
-    bool operator !=(const istream_iterator_until &other) const {
+    bool operator ==(const TokenIterator &other) const {
+        return pos == other.pos;  // past each token: unique
+    }
+    bool operator !=(const TokenIterator &other) const {
         return not (*this == other);
     }
+};
+
+
+struct TokenRange {
+    Span span;
+    Separators seps;
+    bool empties;
+
+    TokenRange(const Span &span, const char *seps, bool empties) :
+        span(span), seps(seps), empties(empties) {}
+
+    TokenIterator begin() const { return TokenIterator(span, seps, empties); }
+    TokenIterator end() const { return TokenIterator(); }
+};
 
-    bool operator ==(const istream_iterator_until &other) const {
-        if(at_end)
-            return other.at_end;
 
-        if(other.at_end)
-            return false;
+// The range keeps the separators: iterators must not outlive it
+inline TokenRange
+tokens(const Span &span, const char *seps, bool empties=false)
+{
+    return TokenRange(span, seps, empties);
+}
+
+
+class InputReader {
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapped = MAP_FAILED;
+    std::vector<char> buffer;  // if it could not be mapped
+
+    static const size_t BLOCKSIZE = 1 << 20;
+
+public:
+    InputReader(const char *path) {
+        auto fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+        if(fd < 0)
+            return;
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped != MAP_FAILED) {
+                madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(mapped);
+                size = st.st_size;
+            }
+        }
+        if(mapped == MAP_FAILED) {
+            for(ssize_t n=1; n > 0; size += n) {
+                buffer.resize(size + BLOCKSIZE);
+                n = read(fd, &buffer[size], BLOCKSIZE);
+                n = std::max<ssize_t>(n, 0);
+            }
+            data = buffer.data();
+        }
+        if(path)
+            close(fd);
+    }
 
-        return iter == other.iter;
+    ~InputReader() {
+        if(mapped != MAP_FAILED)
+            munmap(mapped, size);
     }
+
+    InputReader(const InputReader &) = delete;
+    InputReader &operator =(const InputReader &) = delete;
+
+    Span all() const { return Span(data, data + size); }
+
+    // Lines without the '\n', empty ones included
+    TokenRange lines() const { return tokens(all(), "\n", true); }
 };
 
 
@@ -176,26 +296,115 @@ nw_align_affine_gap(iter a1, iter a2, iter b1, iter b2)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 int
 main(int argc, char *argv[]) {
-    std::ifstream stream(argv[1]);
-    stream.imbue(std::locale(stream.getloc(), new SeparatorReader("")));
-
-    std::vector<char> seqs(400);  // 400 is problem limit
-    auto first = seqs.begin();
+    InputReader reader(argv[1]);
 
-    auto in2 = istream_iterator_until<char>();
-    while (stream) {
-        auto in1 = istream_iterator_until<char>(stream, '\n');
-        auto last = std::copy(in1, in2, first);
-        if(first == last)
-            break;  // nothing read
+    for(auto &&line: reader.lines()) {
+        auto seqs = tokens(line, " |");  // GAAAAAAT | GAAT
+        auto seqa = seqs.begin();
+        if(seqa == seqs.end())
+            continue;  // nothing read
 
-        auto seqa_end = std::find(seqs.begin(), last, ' ');
-        auto seqb_start = ++std::find(std::next(seqa_end), last, ' ');
+        auto seqb = std::next(seqa);
+        auto none = Span(seqa->end(), seqa->end());  // no 2nd sequence
+        auto &b = seqb != seqs.end() ? *seqb : none;
 
-        auto maxscore = nw_align_affine_gap(first, seqa_end, seqb_start, last);
-        std::cout << maxscore << std::endl;
+        auto maxscore = nw_align_affine_gap(seqa->begin(), seqa->end(),
+                                            b.begin(), b.end());
+        sink << maxscore << '\n';
     }
     return 0;
 }
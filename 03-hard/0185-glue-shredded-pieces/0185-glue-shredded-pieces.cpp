@@ -23,6 +23,7 @@
 // Headers for the implementation
 #include <algorithm>
 #include <iterator>
+#include <limits>
 #include <map>
 #include <type_traits>
 #include <vector>
@@ -31,6 +32,8 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <unistd.h>
+
 /*
   This problem can be solved by applying the Eulerian Path approach. The
   problem constraints dictate that there is one and only one solution which
@@ -195,6 +198,127 @@ template<typename T> using MAllocDyn = Mallocator<T, MemCacheDynamic>;
 template<typename T> using MAllocOne = Mallocator<T, MemCacheOne>;
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+// Output iterator on the sink: each value is converted to T and followed by
+// the delimiter, like with std::ostream_iterator
+template <typename T>
+struct SinkIterator {
+    OutputSink *sink;
+    const char *delim;
+
+    using value_type = void;
+    using difference_type = void;
+    using pointer = void;
+    using reference = void;
+    using iterator_category = std::output_iterator_tag;
+
+    SinkIterator(OutputSink &sink, const char *delim=nullptr) :
+        sink(&sink), delim(delim) {}
+
+    SinkIterator &operator =(const T &value) {
+        *sink << value;
+        if(delim)
+            *sink << delim;
+        return *this;
+    }
+
+    SinkIterator &operator *() { return *this; }
+    SinkIterator &operator ++() { return *this; }
+    SinkIterator &operator ++(int) { return *this; }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 /*
   Specific std::string substitute ad-hoc for the problem
     Methods provided: substr, size
@@ -215,6 +339,7 @@ template<typename T> using MAllocOne = Mallocator<T, MemCacheOne>;
      With the default allocator the memory consumption is 4x and used time is
      2x (see also the contribution by the std::map with custom allocators)
 
+
   Note: For std::map a custom allocator is a much better solutions. Unluckily
   std::string is already a specialized version of basic_string and a custom
   allocator cannot be provided.
@@ -276,13 +401,13 @@ struct PoolString
     ~PoolString() { getpool().dealloc(static_cast<void *>(data)); }
 
     friend void
-    swap(const PoolString &ps1, const PoolString &ps2) { std::swap(ps1.data, ps2.data); }
+    swap(PoolString &ps1, PoolString &ps2) { std::swap(ps1.data, ps2.data); }
 
     friend std::istream &
     operator >>(std::istream &is, PoolString &ps) { return is >> ps.data; }
 
-    friend std::ostream &
-    operator <<(std::ostream &os, const PoolString &ps) { return os << ps.data; }
+    friend OutputSink &
+    operator <<(OutputSink &os, const PoolString &ps) { return os << ps.data; }
 
     size_t size() const noexcept { return std::strlen(data); }
 
@@ -307,7 +432,7 @@ glue(iter &&a1, iter &&a2, iterout &&o1, bool eol=false)
 {
     using TKmer = typename std::decay<decltype(*a1)>::type;
 
-    using TNodePair = std::pair<TKmer, int>;
+    using TNodePair = std::pair<const TKmer, int>;
     // Using the allocator saves memory/time
     using TNodeBalance = std::map<TKmer, int, std::less<TKmer>, MAllocOne<TNodePair>>;
 
@@ -317,7 +442,7 @@ glue(iter &&a1, iter &&a2, iterout &&o1, bool eol=false)
     // Consumes more memory and is slightly slower
     // using TNodeList = std::vector<const TKmer *, MAllocDyn<const TKmer *>>;
 
-    using TEdgePair = std::pair<const TKmer *, TNodeList>;
+    using TEdgePair = std::pair<const TKmer *const, TNodeList>;
     // Using the allocator saves memory/time
     using TEdge = std::map<const TKmer *, TNodeList, std::less<const TKmer *>, MAllocOne<TEdgePair>>;
 
@@ -391,12 +516,12 @@ main(int argc, char *argv[]) {
     using PString = PoolString<28>;
 
     auto itin2 = std::istream_iterator<PString>();
-    auto itout = std::ostream_iterator<PString>(std::cout);
+    auto itout = SinkIterator<PString>(sink);
 
     while (stream) {
         auto itin1 = std::istream_iterator<PString>(stream);
         glue(itin1, itin2, itout, true);
-        std::cout << std::endl;
+        sink << '\n';
     }
 
     return 0;
@@ -23,9 +23,14 @@
 
 // Extra headers
 #include <algorithm>  // fill_n
+#include <cstring>  // memcpy, strlen
+#include <iterator>  // end
 #include <memory>  // unique_ptr
 #include <limits>  //numeric_limits
 #include <cstdint>  // uint16_t
+#include <type_traits>  // enable_if
+
+#include <unistd.h>  // write
 
 // Cell Type and Cells (Array Length) types
 typedef unsigned char cell_t;
@@ -46,6 +51,99 @@ const int TOTALCELLS = 8192;
   unknown/unbounded length, because it operates on a stream
 */
 
+
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 std::istream &
 bfck(std::istream &is, const size_t &totalcells=TOTALCELLS)
 {
@@ -109,7 +207,7 @@ bfck(std::istream &is, const size_t &totalcells=TOTALCELLS)
                 break;
 
             case '.':
-                std::cout << cells[cellptr];
+                sink << cells[cellptr];
                 break;
         }
     }
@@ -121,7 +219,7 @@ int main(int argc, char *argv[]) {
     std::ifstream stream(argv[1]);
 
     while(bfck(stream))
-        std::cout << std::endl;  // separation amongst tests
+        sink << '\n';  // separation amongst tests
 
     return 0;
 }
@@ -21,84 +21,199 @@
 
 // Headers for the implementation
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-template <typename T, typename T2>
-struct istream_iterator_until {
-    std::istream *is;
-    using TIter = std::istream_iterator<T>;
-    TIter iter;
-    TIter last;
-    T2 tuntil;
-    using T2iter = typename T2::const_iterator;
-    T2iter ubegin, uend;
-    bool at_end;
 
-    using value_type = T;
-    using difference_type = std::ptrdiff_t;
-    using pointer = T *;
-    using reference = T &;
-    using iterator_category = std::output_iterator_tag;
+///////////////////////////////////////////////////////////////////////////////
+// Zero-copy Input Reader
+//
+// The whole input is mapped (or read in large blocks if it cannot be mapped,
+// like a pipe) and lines/tokens are handed out as spans pointing into it.
+//
+//   InputReader reader(argv[1]);
+//   for(auto &&line: reader.lines())
+//       for(auto &&token: tokens(line, " ,|"))
+//           std::copy(token.begin(), token.end(), out);
+///////////////////////////////////////////////////////////////////////////////
+struct Span {
+    const char *first = nullptr;
+    const char *last = nullptr;
+
+    Span() {}
+    Span(const char *first, const char *last) : first(first), last(last) {}
+
+    const char *begin() const { return first; }
+    const char *end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    char operator [](size_t i) const { return first[i]; }
+    std::string str() const { return std::string(first, last); }
+};
 
-    istream_iterator_until() : at_end(true) {}
 
-    istream_iterator_until(std::istream &is, const T2 &until) :
-        is(&is), iter(is), last(),
-        tuntil(until), ubegin(std::begin(tuntil)), uend(std::end(tuntil)),
-        at_end((not is) ? true : std::find(ubegin, uend, *iter) != uend)
-        {}
+// Set of separators for the tokens
+struct Separators {
+    bool table[256] = {};
+    int single = -1;  // only one separator: searched for with memchr
 
-    T operator *() const { return *iter; }
-    T until() const { T _tmp; is->unget() >> _tmp; return _tmp; }
+    Separators(const char *seps) {
+        auto n = 0;
+        for(; *seps; seps++, n++)
+            table[static_cast<unsigned char>(*seps)] = true;
+        if(n == 1)
+            single = static_cast<unsigned char>(seps[-1]);
+    }
 
-    istream_iterator_until& operator ++() {
-        iter++;
-        at_end = iter == last or std::find(ubegin, uend, *iter) != uend;
-        return *this;
+    bool operator ()(char c) const {
+        return table[static_cast<unsigned char>(c)];
     }
 
-    istream_iterator_until operator ++(int) {
-        istream_iterator_until tmp = *this;
-        ++(*this);
-        return tmp;
+    // First separator in [first, last) or last
+    const char *find(const char *first, const char *last) const {
+        if(single >= 0) {
+            auto p = std::memchr(first, single, last - first);
+            return p ? static_cast<const char *>(p) : last;
+        }
+        while(first != last and not table[static_cast<unsigned char>(*first)])
+            first++;
+        return first;
+    }
+};
+
+
+// Splits a span at the separators, skipping empty tokens (like the stream
+// does with whitespace) unless empties is set (like getline does with lines)
+struct TokenIterator {
+    const char *pos = nullptr;
+    const char *last = nullptr;
+    const Separators *seps = nullptr;
+    bool empties = false;
+    Span token;
+
+    using value_type = Span;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Span *;
+    using reference = const Span &;
+    using iterator_category = std::forward_iterator_tag;
+
+    TokenIterator() {}  // end of any span
+
+    TokenIterator(const Span &span, const Separators &seps, bool empties) :
+        pos(span.first), last(span.last), seps(&seps), empties(empties) {
+        next();
+    }
+
+    void next() {
+        if(not empties)
+            while(pos != last and (*seps)(*pos))
+                pos++;
+
+        if(pos == last) {
+            pos = nullptr;  // equal to the end iterator
+            return;
+        }
+        auto tend = seps->find(pos, last);
+        token = Span(pos, tend);
+        pos = tend + (empties and tend != last);  // skip the separator
     }
 
-    bool operator !=(const istream_iterator_until &other) const { return not is_equal(other); }
-    bool operator ==(const istream_iterator_until &other) const { return is_equal(other); }
+    reference operator *() const { return token; }
+    pointer operator ->() const { return &token; }
 
-    bool is_equal(const istream_iterator_until &other) const {
-        if(at_end)
-            return other.at_end;
+    TokenIterator &operator ++() { next(); return *this; }
 
-        if(other.at_end)
-            return false;
+    TokenIterator operator ++(int) {
+        auto tmp = *this;
+        next();
+        return tmp;
+    }
 
-        return iter == other.iter;
+    bool operator ==(const TokenIterator &other) const {
+        return pos == other.pos;  // past each token: unique
+    }
+    bool operator !=(const TokenIterator &other) const {
+        return not (*this == other);
     }
 };
 
 
-///////////////////////////////////////////////////////////////////////////////
-// Stream Imbuer for Parsing
-// http://stackoverflow.com/questions/1894886/parsing-a-comma-delimited-stdstring
-//    ss.imbue(std::locale(ss.getloc(), new SeparatorReader(" ,|")));
-///////////////////////////////////////////////////////////////////////////////
+struct TokenRange {
+    Span span;
+    Separators seps;
+    bool empties;
+
+    TokenRange(const Span &span, const char *seps, bool empties) :
+        span(span), seps(seps), empties(empties) {}
 
-struct SeparatorReader: std::ctype<char>
+    TokenIterator begin() const { return TokenIterator(span, seps, empties); }
+    TokenIterator end() const { return TokenIterator(); }
+};
+
+
+// The range keeps the separators: iterators must not outlive it
+inline TokenRange
+tokens(const Span &span, const char *seps, bool empties=false)
 {
-    template<typename T>
-    SeparatorReader(const T &seps): std::ctype<char>(get_table(seps), true) {}
+    return TokenRange(span, seps, empties);
+}
 
-    template<typename T>
-    std::ctype_base::mask const *get_table(const T &seps) {
-        auto &&rc = new std::ctype_base::mask[std::ctype<char>::table_size]();
-        for(auto &&sep: seps)
-            rc[static_cast<unsigned char>(sep)] = std::ctype_base::space;
-        return &rc[0];
+
+class InputReader {
+    const char *data = nullptr;
+    size_t size = 0;
+    void *mapped = MAP_FAILED;
+    std::vector<char> buffer;  // if it could not be mapped
+
+    static const size_t BLOCKSIZE = 1 << 20;
+
+public:
+    InputReader(const char *path) {
+        auto fd = path ? open(path, O_RDONLY) : STDIN_FILENO;
+        if(fd < 0)
+            return;
+
+        struct stat st;
+        if(fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+            mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if(mapped != MAP_FAILED) {
+                madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+                data = static_cast<const char *>(mapped);
+                size = st.st_size;
+            }
+        }
+        if(mapped == MAP_FAILED) {
+            for(ssize_t n=1; n > 0; size += n) {
+                buffer.resize(size + BLOCKSIZE);
+                n = read(fd, &buffer[size], BLOCKSIZE);
+                n = std::max<ssize_t>(n, 0);
+            }
+            data = buffer.data();
+        }
+        if(path)
+            close(fd);
     }
+
+    ~InputReader() {
+        if(mapped != MAP_FAILED)
+            munmap(mapped, size);
+    }
+
+    InputReader(const InputReader &) = delete;
+    InputReader &operator =(const InputReader &) = delete;
+
+    Span all() const { return Span(data, data + size); }
+
+    // Lines without the '\n', empty ones included
+    TokenRange lines() const { return tokens(all(), "\n", true); }
 };
 
 
@@ -120,13 +235,104 @@ visit_node(T &forest, int ROWSSIZE, int m, int n, bool start=false)
     return start;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Output Sink
+//
+// Output is collected in a large buffer and handed to write(2) when full and
+// once at exit (destructor of the global). Integers are formatted by hand: no
+// locale and no stream state
+//
+//   sink << 12 << ' ' << "abc" << '\n';
+///////////////////////////////////////////////////////////////////////////////
+class OutputSink {
+    static const size_t BUFSIZE = 1 << 16;
+    char buffer[BUFSIZE];
+    size_t used = 0;
+    int fd;
+
+    void write_all(const char *s, size_t n) {
+        for(size_t done=0; done < n;) {
+            auto w = ::write(fd, s + done, n - done);
+            if(w <= 0)
+                break;  // nowhere to report it
+            done += w;
+        }
+    }
+
+public:
+    OutputSink(int fd=STDOUT_FILENO) : fd(fd) {}
+    ~OutputSink() { flush(); }
+
+    OutputSink(const OutputSink &) = delete;
+    OutputSink &operator =(const OutputSink &) = delete;
+
+    void flush() {
+        write_all(buffer, used);
+        used = 0;
+    }
+
+    OutputSink &write(const char *s, size_t n) {
+        if(used + n > BUFSIZE) {
+            flush();
+            if(n > BUFSIZE) {  // straight from the source
+                write_all(s, n);
+                return *this;
+            }
+        }
+        std::memcpy(buffer + used, s, n);
+        used += n;
+        return *this;
+    }
+
+    OutputSink &operator <<(char c) {
+        if(used == BUFSIZE)
+            flush();
+        buffer[used++] = c;
+        return *this;
+    }
+
+    // like iostream: the character, not the number
+    OutputSink &operator <<(signed char c) { return *this << char(c); }
+    OutputSink &operator <<(unsigned char c) { return *this << char(c); }
+
+    OutputSink &operator <<(const char *s) { return write(s, std::strlen(s)); }
+
+    OutputSink &operator <<(const std::string &s) {
+        return write(s.data(), s.size());
+    }
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value, OutputSink &>::type
+    operator <<(T value) {
+        char digits[24];
+        auto p = std::end(digits);
+        auto negative = value < 0;
+        // unsigned: the minimum of a signed type has no positive counterpart
+        auto u = static_cast<typename std::make_unsigned<T>::type>(value);
+        if(negative)
+            u = -u;
+
+        do {
+            *--p = '0' + u % 10;
+            u /= 10;
+        } while(u);
+
+        if(negative)
+            *--p = '-';
+        return write(p, std::end(digits) - p);
+    }
+};
+
+
+OutputSink sink;  // flushed at exit
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Main
 ///////////////////////////////////////////////////////////////////////////////
 int
 main(int argc, char *argv[]) {
-    std::ifstream stream(argv[1]);
-    stream.imbue(std::locale(stream.getloc(), new SeparatorReader(" ")));
+    InputReader reader(argv[1]);
 
     const int MAXSIZE = 30;
     const int OVERSIZE = MAXSIZE + 2;
@@ -135,9 +341,7 @@ main(int argc, char *argv[]) {
     auto forest = std::vector<int>(TOTALSIZE);
     auto fbegin = forest.begin();
 
-    auto in2 = istream_iterator_until<char, std::string>();
-
-    while (stream) {
+    for(auto &&line: reader.lines()) {
         std::fill_n(fbegin, TOTALSIZE, 0);  // reset forest
 
         // skip pad left col and pad top row
@@ -145,28 +349,28 @@ main(int argc, char *argv[]) {
         auto frows = 0, fcols = 0;
 
         auto fstart = ffirst;
-        while(true) {
-            auto in1 = istream_iterator_until<char, std::string>(stream, "|\n");
-            // auto fstop = std::copy(in1, in2, fstart);
+        for(auto &&row: tokens(line, "|")) {  // o # o | # # # | o # o
+            auto cells = tokens(row, " ");
             auto fstop = std::transform(
-                in1, in2, fstart, [] (const char &c) -> int { return c == 'o' ? 1 : 0; });
+                cells.begin(), cells.end(), fstart,
+                [] (const Span &cell) -> int { return cell[0] == 'o'; });
+            if(fstop == fstart)
+                continue;  // blanks only
+
             fcols = std::distance(fstart, fstop);
             frows++;
-
-            if(in1.until() == '\n' or not stream)
-                break;  // end of foret or eof
             std::advance(fstart, OVERSIZE);
         }
 
         if(not fcols)
-            break;  // nothing was read
+            continue;  // nothing was read
 
         auto lakes = 0;
         for(auto m=1; m < frows + 1; m++)
             for(auto n=1; n < fcols + 1; n++)
                 lakes += visit_node(forest, OVERSIZE, m, n, true);
 
-        std::cout << lakes << std::endl;
+        sink << lakes << '\n';
     }
     return 0;
 }